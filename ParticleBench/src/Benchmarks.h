@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Every benchmark prints a single JSON object to stdout and returns the process exit code
+namespace Benchmarks
+{
+	int Parse(const std::string& filename);
+	int Simulate(const std::vector<std::string>& filenames, float simulated_seconds, float dt);
+	int Expressions(int emitter_count, int frames);
+	int Layouts(const std::string& filename, size_t particles, int steps);
+	int Threads(const std::string& filename, int emitters, size_t particles, int steps);
+	int Raster(const std::string& filename, size_t particles, int width, int height, int frames);
+
+	size_t PeakMemory();
+	// Contents of a JSON string literal for text like file names, quotes not included
+	std::string EscapeJson(const std::string& text);
+}
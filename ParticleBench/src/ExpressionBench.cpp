@@ -0,0 +1,88 @@
+#include "Benchmarks.h"
+
+#include "Utils/PropertyBindings.h"
+
+#include <chrono>
+#include <vector>
+#include <fmt/core.h>
+
+namespace Benchmarks
+{
+	static const char* const SOURCES[] = {
+		"2 + sin(t) * 0.5",
+		"1 + abs(sin(t * 3))",
+		"1 + abs(cos(t * 3))",
+		"1",
+		"5 + 5 * fract(t)",
+		"100 * cos(t)",
+		"100 * sin(t)",
+		"0",
+		"-98.1 * step(2, mod(t, 4))",
+		"sin(t) * 200",
+		"t * 90 % 360",
+		"lerp(0, 45, clamp(t / 10, 0, 1))",
+		"pow(2, -t)",
+		"max(0.01, 0.05 - t * 0.001)",
+		"0.2 + 0.2 * sin(t * pi)",
+		"2 * pi"
+	};
+
+	int Expressions(int emitterCount, int frames)
+	{
+		std::vector<PropertyBindings> bindings(emitterCount);
+		std::vector<ParticleEmitter> emitters(emitterCount);
+
+		// 15 of the 16 targets bound per emitter, rotating which one is left out
+		int bound = 0;
+		int instructions = 0;
+		for (int i = 0; i < emitterCount; i++)
+		{
+			for (int target = 0; target < PropertyBindings::COUNT; target++)
+			{
+				if (target == i % PropertyBindings::COUNT)
+					continue;
+				bindings[i].Bind((BindingTarget)target, SOURCES[target]);
+				instructions += bindings[i].GetExpression((BindingTarget)target).GetInstructionCount();
+				bound++;
+			}
+		}
+
+		const float dt = 1.0f / 60.0f;
+		volatile float sink = 0.0f;
+
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			float t = frame * dt;
+			float sum = 0.0f;
+			for (const PropertyBindings& binding : bindings)
+			{
+				for (int target = 0; target < PropertyBindings::COUNT; target++)
+					sum += binding.GetExpression((BindingTarget)target).Evaluate(t);
+			}
+			sink = sink + sum;
+		}
+		auto middle = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			float t = frame * dt;
+			for (int i = 0; i < emitterCount; i++)
+				bindings[i].Apply(&emitters[i], t);
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double evaluateSeconds = std::chrono::duration<double>(middle - start).count();
+		double applySeconds = std::chrono::duration<double>(end - middle).count();
+		double evaluations = (double)bound * frames;
+
+		fmt::print("{{\n\t\"benchmark\": \"expressions\",\n");
+		fmt::print("\t\"emitters\": {},\n\t\"bound_properties\": {},\n\t\"average_instructions\": {:.2f},\n\t\"frames\": {},\n",
+			emitterCount, bound, (double)instructions / bound, frames);
+		fmt::print("\t\"evaluate\": {{ \"ms_per_frame\": {:.4f}, \"ns_per_expression\": {:.2f} }},\n",
+			evaluateSeconds * 1e3 / frames, evaluateSeconds * 1e9 / evaluations);
+		fmt::print("\t\"apply_to_emitters\": {{ \"ms_per_frame\": {:.4f}, \"ns_per_expression\": {:.2f} }}\n}}\n",
+			applySeconds * 1e3 / frames, applySeconds * 1e9 / evaluations);
+
+		return 0;
+	}
+}
@@ -0,0 +1,116 @@
+#include "Benchmarks.h"
+
+#include "Utils/ParticleSerializer.h"
+#include "Simulation/ParticleSystem.h"
+#include "Simulation/SoaKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+
+namespace Benchmarks
+{
+	struct LayoutResult
+	{
+		std::string name;
+		double seconds = 0.0;
+		double particleUpdates = 0.0;
+		uint64_t hash = 0;
+		float maxDifference = 0.0f;
+	};
+
+	// Largest difference between two saved states, read as floats. Infinity if the layouts differ.
+	static float StateDifference(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+	{
+		if (a.size() != b.size())
+			return INFINITY;
+
+		float difference = 0.0f;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			float x, y;
+			std::memcpy(&x, &a[i], sizeof(x));
+			std::memcpy(&y, &b[i], sizeof(y));
+			if (a[i] != b[i])
+				difference = std::max(difference, std::fabs(x - y));
+		}
+		return difference;
+	}
+
+	int Layouts(const std::string& filename, size_t particles, int steps)
+	{
+		ParticleEmitter emitter;
+		if (!ParticleSerializer::Deserialize(filename, &emitter))
+			return 1;
+
+		const float dt = 1.0f / 60.0f;
+		EmitterSettings settings = EmitterSettings::FromEmitter(emitter, {0.0f, 0.0f});
+		// Spawns fast enough to keep about the requested number alive
+		settings.lifetime = std::max(settings.lifetime, dt);
+		settings.spawnInterval = settings.lifetime / particles;
+		int warmup = (int)std::ceil(settings.lifetime / dt) + 1;
+
+		struct Config
+		{
+			ParticleLayout layout;
+			SoaKernels::Level level;
+		};
+		std::vector<Config> configs = {{ParticleLayout::ArrayOfStructs, SoaKernels::Level::Scalar}};
+		for (int i = 0; i <= (int)SoaKernels::GetSupportedLevel(); i++)
+			configs.push_back({ParticleLayout::StructOfArrays, (SoaKernels::Level)i});
+
+		SoaKernels::Level previousLevel = SoaKernels::GetLevel();
+		std::vector<LayoutResult> results;
+		std::vector<uint32_t> reference;
+		std::vector<uint32_t> state;
+		for (const Config& config : configs)
+		{
+			ParticlePool pool(particles + particles / 8, config.layout);
+			ParticleSystem system(&pool);
+			system.Reset(1);
+			SoaKernels::SetLevel(config.level);
+
+			for (int i = 0; i < warmup; i++)
+				system.Step(settings, dt);
+
+			LayoutResult result;
+			result.name = config.layout == ParticleLayout::ArrayOfStructs ? "aos" : fmt::format("soa_{}", SoaKernels::GetName(config.level));
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < steps; i++)
+			{
+				system.Step(settings, dt);
+				result.particleUpdates += system.GetCount();
+			}
+			auto end = std::chrono::steady_clock::now();
+			result.seconds = std::chrono::duration<double>(end - start).count();
+			result.hash = system.GetStateHash();
+
+			system.SaveState(&state);
+			if (results.empty())
+				reference = state;
+			result.maxDifference = StateDifference(reference, state);
+			results.push_back(result);
+		}
+		SoaKernels::SetLevel(previousLevel);
+
+		fmt::print("{{\n\t\"benchmark\": \"layouts\",\n");
+		fmt::print("\t\"file\": \"{}\",\n\t\"particles\": {},\n\t\"steps\": {},\n", EscapeJson(filename), particles, steps);
+		fmt::print("\t\"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const LayoutResult& result = results[i];
+			fmt::print("\t\t{{ \"layout\": \"{}\", \"wall_seconds\": {:.6f}, \"ns_per_particle_update\": {:.3f}, "
+				"\"speedup\": {:.2f}, \"state_hash\": \"{:016x}\", \"max_difference\": {} }}{}\n",
+				result.name, result.seconds, result.seconds * 1e9 / std::max(result.particleUpdates, 1.0),
+				results[0].seconds / std::max(result.seconds, 1e-9), result.hash, result.maxDifference,
+				i + 1 < results.size() ? "," : "");
+		}
+		fmt::print("\t]\n}}\n");
+
+		return 0;
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+#include <Difu/Particles/ParticleEmitter.h>
+
+namespace LegacyParser
+{
+	// Throws like the original on missing fields or malformed numbers
+	void Parse(const std::string& text, ParticleEmitter* emitter);
+}
@@ -0,0 +1,112 @@
+#include "Benchmarks.h"
+#include "LegacyParser.h"
+
+#include "Utils/ParticleSerializer.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <fmt/core.h>
+
+namespace Benchmarks
+{
+	struct ParseResult
+	{
+		double seconds = 0.0;
+		size_t bytes = 0;
+		size_t emitters = 0;
+	};
+
+	template<typename ParseFunction>
+	static ParseResult Measure(const std::vector<std::string>& inputs, int repeats, ParseFunction parse)
+	{
+		ParseResult result;
+		ParticleEmitter emitter;
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < repeats; i++)
+		{
+			for (const std::string& input : inputs)
+			{
+				parse(input, &emitter);
+				result.bytes += input.size();
+				result.emitters++;
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		result.seconds = std::chrono::duration<double>(end - start).count();
+		return result;
+	}
+
+	static void PrintResult(const char* name, const ParseResult& legacy, const ParseResult& current, bool last)
+	{
+		auto print = [](const char* parser, const ParseResult& result, bool comma)
+		{
+			fmt::print("\t\t\t\"{}\": {{ \"emitters\": {}, \"ns_per_emitter\": {:.1f}, \"mb_per_second\": {:.2f} }}{}\n",
+				parser, result.emitters, result.seconds * 1e9 / result.emitters, result.bytes / result.seconds / 1e6, comma ? "," : "");
+		};
+
+		fmt::print("\t\t\"{}\": {{\n", name);
+		print("legacy", legacy, true);
+		print("current", current, true);
+		fmt::print("\t\t\t\"speedup\": {:.2f}\n", legacy.seconds / current.seconds);
+		fmt::print("\t\t}}{}\n", last ? "" : ",");
+	}
+
+	static std::string GenerateEmitter(int index)
+	{
+		return fmt::format(
+			"Emitter{}\n{{\n"
+			"\tLIFETIME : float : {};\n"
+			"\tRESOLUTION : vector2f : {{ 1, 1 }};\n"
+			"\tMIN_SIZE_FACTOR : float : 1;\n"
+			"\tMAX_SIZE_FACTOR : float : {};\n"
+			"\tVELOCITY : vector2f : {{ {}, 0 }};\n"
+			"\tACCELERATION : vector2f : {{ 0, -9.81 }};\n"
+			"\tCENTRIPETAL_ACCELERATION : float : 70;\n"
+			"\tROTATION : float : 0;\n"
+			"\tROTATION_VELOCITY : float : 0.5;\n"
+			"\tROTATION_ACCELERATION : float : 0;\n"
+			"\tSTART_COLOR : color : #FFF146B5;\n"
+			"\tEND_COLOR : color : #00E5EC17;\n"
+			"\tSPAWN_INTERVAL : float : 0.01;\n"
+			"\tRANDOMNESS : float : 0.4;\n"
+			"\tSPREAD : float : 6.28319;\n"
+			"}}",
+			index, 0.5f + index % 100 * 0.03f, 2 + index % 9, 10 * (index % 50));
+	}
+
+	int Parse(const std::string& filename)
+	{
+		std::ifstream in(filename);
+		if (!in)
+		{
+			fmt::print(stderr, "Could not open {}\n", filename);
+			return 1;
+		}
+		std::stringstream ss;
+		ss << in.rdbuf();
+		std::vector<std::string> single = { ss.str() };
+
+		ParticleEmitter check;
+		if (!ParticleSerializer::ParseText(single[0], &check, nullptr, filename))
+			return 1;
+
+		std::vector<std::string> many;
+		many.reserve(10000);
+		for (int i = 0; i < 10000; i++)
+			many.push_back(GenerateEmitter(i));
+
+		auto legacy = [](const std::string& text, ParticleEmitter* emitter) { LegacyParser::Parse(text, emitter); };
+		auto current = [](const std::string& text, ParticleEmitter* emitter) { ParticleSerializer::ParseText(text, emitter); };
+
+		fmt::print("{{\n\t\"benchmark\": \"parse\",\n\t\"input\": \"{}\",\n\t\"results\": {{\n", EscapeJson(filename));
+		PrintResult("single_file", Measure(single, 20000, legacy), Measure(single, 20000, current), false);
+		PrintResult("10k_emitters", Measure(many, 2, legacy), Measure(many, 2, current), true);
+		fmt::print("\t}}\n}}\n");
+
+		return 0;
+	}
+}
@@ -0,0 +1,96 @@
+#include "Benchmarks.h"
+
+#include "Utils/ParticleSerializer.h"
+#include "Utils/JobSystem.h"
+#include "Utils/SoftwareRasterizer.h"
+#include "Simulation/ParticleSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+
+namespace Benchmarks
+{
+	struct RasterResult
+	{
+		unsigned threads = 0;
+		double seconds = 0.0;
+		uint64_t hash = 0;
+	};
+
+	// FNV-1a over the image
+	static uint64_t HashPixels(const Color* pixels, size_t count)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		const unsigned char* bytes = (const unsigned char*)pixels;
+		for (size_t i = 0; i < count * sizeof(Color); i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	int Raster(const std::string& filename, size_t particles, int width, int height, int frames)
+	{
+		ParticleEmitter emitter;
+		if (!ParticleSerializer::Deserialize(filename, &emitter))
+			return 1;
+
+		const float dt = 1.0f / 60.0f;
+		EmitterSettings settings = EmitterSettings::FromEmitter(emitter, {width / 2.0f, height / 2.0f});
+		settings.lifetime = std::max(settings.lifetime, dt);
+		settings.spawnInterval = settings.lifetime / particles;
+
+		ParticleSystem system;
+		system.Reset(1);
+		int warmup = (int)std::ceil(settings.lifetime / dt) + 1;
+		for (int i = 0; i < warmup; i++)
+			system.Step(settings, dt);
+
+		unsigned maxThreads = std::max(8u, std::thread::hardware_concurrency());
+		std::vector<RasterResult> results;
+		size_t binned = 0;
+		for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			JobSystem jobs;
+			jobs.Start(threads - 1);
+			SoftwareRasterizer rasterizer;
+			rasterizer.Resize(width, height);
+
+			RasterResult result;
+			result.threads = threads;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < frames; i++)
+			{
+				rasterizer.Begin(WHITE);
+				rasterizer.Add(system, settings, 1.0f);
+				rasterizer.End(&jobs);
+			}
+			auto end = std::chrono::steady_clock::now();
+			result.seconds = std::chrono::duration<double>(end - start).count();
+			result.hash = HashPixels(rasterizer.GetPixels(), (size_t)width * height);
+			binned = rasterizer.GetBinnedCount();
+			results.push_back(result);
+		}
+
+		fmt::print("{{\n\t\"benchmark\": \"raster\",\n");
+		fmt::print("\t\"file\": \"{}\",\n\t\"particles\": {},\n\t\"width\": {},\n\t\"height\": {},\n\t\"frames\": {},\n\t\"tile_bins\": {},\n\t\"hardware_threads\": {},\n",
+			EscapeJson(filename), system.GetCount(), width, height, frames, binned, std::thread::hardware_concurrency());
+		fmt::print("\t\"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const RasterResult& result = results[i];
+			fmt::print("\t\t{{ \"threads\": {}, \"ms_per_frame\": {:.3f}, \"speedup\": {:.2f}, \"image_hash\": \"{:016x}\", \"matches_serial\": {} }}{}\n",
+				result.threads, result.seconds * 1000.0 / frames, results[0].seconds / std::max(result.seconds, 1e-9),
+				result.hash, result.hash == results[0].hash ? "true" : "false", i + 1 < results.size() ? "," : "");
+		}
+		fmt::print("\t]\n}}\n");
+
+		return 0;
+	}
+}
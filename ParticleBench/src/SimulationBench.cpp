@@ -0,0 +1,152 @@
+#include "Benchmarks.h"
+
+#include "Utils/ParticleSerializer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOGDI
+	#define NOUSER
+	#include <windows.h>
+	#include <psapi.h>
+#endif
+
+namespace Benchmarks
+{
+	std::string EscapeJson(const std::string& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char c : text)
+		{
+			switch (c)
+			{
+			case '"':
+				escaped += "\\\"";
+				break;
+			case '\\':
+				escaped += "\\\\";
+				break;
+			case '\n':
+				escaped += "\\n";
+				break;
+			case '\r':
+				escaped += "\\r";
+				break;
+			case '\t':
+				escaped += "\\t";
+				break;
+			default:
+				// Other control characters have no short form, UTF-8 passes through as is
+				if ((unsigned char)c < 0x20)
+					escaped += fmt::format("\\u{:04x}", (unsigned char)c);
+				else
+					escaped += c;
+			}
+		}
+		return escaped;
+	}
+
+	// Peak resident memory of the whole process in bytes, 0 if unknown
+	size_t PeakMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.PeakWorkingSetSize;
+		return 0;
+#else
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			// VmHWM:     1234 kB
+			if (line.compare(0, 6, "VmHWM:") == 0)
+				return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+		}
+		return 0;
+#endif
+	}
+
+	// ParticleEmitter does not expose its particles, so counts follow from the
+	// spawn rate: one particle per interval, each living for the particle lifetime
+	static size_t EstimateLiveParticles(const ParticleEmitter& emitter, double time)
+	{
+		float interval = emitter.GetSpawnInterval();
+		if (interval <= 0.0f)
+			return 0;
+
+		double alive = std::min(time, (double)emitter.GetParticleLifetime());
+		return (size_t)std::floor(std::max(alive, 0.0) / interval);
+	}
+
+	struct SimulationResult
+	{
+		std::string file;
+		double seconds = 0.0;
+		size_t steps = 0;
+		double particleUpdates = 0.0;
+		size_t peakParticles = 0;
+	};
+
+	int Simulate(const std::vector<std::string>& filenames, float simulatedSeconds, float dt)
+	{
+		std::vector<SimulationResult> results;
+
+		for (const std::string& filename : filenames)
+		{
+			ParticleEmitter emitter;
+			if (!ParticleSerializer::Deserialize(filename, &emitter))
+				return 1;
+
+			emitter.SetSpawnPosition({0.0f, 0.0f});
+			emitter.StartEmitting();
+
+			SimulationResult result;
+			result.file = filename;
+			result.steps = (size_t)std::ceil(simulatedSeconds / dt);
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t step = 0; step < result.steps; step++)
+				emitter.Update(dt);
+			auto end = std::chrono::steady_clock::now();
+
+			result.seconds = std::chrono::duration<double>(end - start).count();
+			for (size_t step = 1; step <= result.steps; step++)
+			{
+				size_t live = EstimateLiveParticles(emitter, step * (double)dt);
+				result.particleUpdates += live;
+				result.peakParticles = std::max(result.peakParticles, live);
+			}
+
+			results.push_back(result);
+		}
+
+		fmt::print("{{\n\t\"benchmark\": \"simulate\",\n");
+		fmt::print("\t\"simulated_seconds\": {},\n\t\"dt\": {},\n", simulatedSeconds, dt);
+		fmt::print("\t\"particle_counts\": \"estimated from spawn interval and lifetime\",\n");
+		fmt::print("\t\"peak_memory_bytes\": {},\n", PeakMemory());
+		fmt::print("\t\"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const SimulationResult& result = results[i];
+			double updates = std::max(result.particleUpdates, 1.0);
+			fmt::print("\t\t{{ \"file\": \"{}\", \"wall_seconds\": {:.6f}, \"steps\": {}, \"ns_per_step\": {:.1f}, "
+				"\"particles_per_second\": {:.0f}, \"ns_per_particle_update\": {:.2f}, \"peak_live_particles\": {} }}{}\n",
+				EscapeJson(result.file), result.seconds, result.steps, result.seconds * 1e9 / result.steps,
+				result.particleUpdates / result.seconds, result.seconds * 1e9 / updates, result.peakParticles,
+				i + 1 < results.size() ? "," : "");
+		}
+		fmt::print("\t]\n}}\n");
+
+		return 0;
+	}
+}
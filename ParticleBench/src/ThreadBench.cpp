@@ -0,0 +1,91 @@
+#include "Benchmarks.h"
+
+#include "Utils/ParticleSerializer.h"
+#include "Utils/JobSystem.h"
+#include "Simulation/ParticleScene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+
+namespace Benchmarks
+{
+	struct ThreadResult
+	{
+		unsigned threads = 0;
+		double seconds = 0.0;
+		double particleUpdates = 0.0;
+		uint64_t hash = 0;
+	};
+
+	int Threads(const std::string& filename, int emitterCount, size_t particles, int steps)
+	{
+		ParticleEmitter emitter;
+		if (!ParticleSerializer::Deserialize(filename, &emitter))
+			return 1;
+
+		const float dt = 1.0f / 60.0f;
+		// Emitters side by side, together keeping about the requested number alive
+		std::vector<EmitterSettings> settings;
+		for (int i = 0; i < emitterCount; i++)
+		{
+			EmitterSettings entry = EmitterSettings::FromEmitter(emitter, {i * 100.0f, 0.0f});
+			entry.lifetime = std::max(entry.lifetime, dt);
+			entry.spawnInterval = entry.lifetime * emitterCount / particles;
+			settings.push_back(entry);
+		}
+		int warmup = (int)std::ceil(settings[0].lifetime / dt) + 1;
+
+		// Doubles the thread count up to at least 8, even on machines with fewer cores
+		unsigned maxThreads = std::max(8u, std::thread::hardware_concurrency());
+		std::vector<ThreadResult> results;
+		for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			JobSystem jobs;
+			jobs.Start(threads - 1);
+
+			ParticleScene scene(particles + particles / 8);
+			for (int i = 0; i < emitterCount; i++)
+				scene.Add();
+			scene.Reset(1);
+
+			for (int i = 0; i < warmup; i++)
+				scene.Step(settings.data(), dt, &jobs);
+
+			ThreadResult result;
+			result.threads = threads;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < steps; i++)
+			{
+				scene.Step(settings.data(), dt, &jobs);
+				result.particleUpdates += scene.GetParticleCount();
+			}
+			auto end = std::chrono::steady_clock::now();
+			result.seconds = std::chrono::duration<double>(end - start).count();
+			result.hash = scene.GetStateHash();
+			results.push_back(result);
+		}
+
+		fmt::print("{{\n\t\"benchmark\": \"threads\",\n");
+		fmt::print("\t\"file\": \"{}\",\n\t\"emitters\": {},\n\t\"particles\": {},\n\t\"steps\": {},\n\t\"hardware_threads\": {},\n",
+			EscapeJson(filename), emitterCount, particles, steps, std::thread::hardware_concurrency());
+		fmt::print("\t\"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const ThreadResult& result = results[i];
+			double speedup = results[0].seconds / std::max(result.seconds, 1e-9);
+			fmt::print("\t\t{{ \"threads\": {}, \"wall_seconds\": {:.6f}, \"ns_per_particle_update\": {:.3f}, "
+				"\"speedup\": {:.2f}, \"efficiency\": {:.2f}, \"state_hash\": \"{:016x}\", \"matches_serial\": {} }}{}\n",
+				result.threads, result.seconds, result.seconds * 1e9 / std::max(result.particleUpdates, 1.0),
+				speedup, speedup / result.threads, result.hash, result.hash == results[0].hash ? "true" : "false",
+				i + 1 < results.size() ? "," : "");
+		}
+		fmt::print("\t]\n}}\n");
+
+		return 0;
+	}
+}
@@ -0,0 +1,133 @@
+#include "Benchmarks.h"
+
+#include <Difu/Utils/Logger.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+
+// stdout is reserved for the JSON results
+static void PrintToStderr(std::string value)
+{
+	fmt::print(stderr, "{}\n", value);
+}
+
+static void PrintUsage()
+{
+	fmt::print(stderr,
+		"Usage: ParticleBench <benchmark> [options]\n"
+		"  parse [file]    Text parser throughput, legacy vs current (default file: testsave.txt)\n"
+		"  simulate [--seconds s] [--dt dt] [files...]\n"
+		"                  Steps ParticleEmitter::Update with a fixed dt and no frame cap (default: 10s at 1/60)\n"
+		"  expressions [emitters] [frames]\n"
+		"                  Cost of evaluating time bindings per frame (default: 1000 emitters, 600 frames)\n"
+		"  layouts [file] [particles] [steps]\n"
+		"                  Simulation step cost per particle storage layout and SIMD kernel (default: testsave.txt, 50000, 600)\n"
+		"  threads [file] [emitters] [particles] [steps]\n"
+		"                  Scene step scaling with worker threads (default: testsave.txt, 8, 50000, 600)\n"
+		"  raster [file] [particles] [width] [height] [frames]\n"
+		"                  Software rasterizer cost per frame by thread count (default: testsave.txt, 50000, 1280, 720, 60)\n");
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Bind(&PrintToStderr);
+
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string benchmark = argv[1];
+	if (benchmark == "parse")
+		return Benchmarks::Parse(argc > 2 ? argv[2] : "testsave.txt");
+
+	if (benchmark == "simulate")
+	{
+		float seconds = 10.0f;
+		float dt = 1.0f / 60.0f;
+		std::vector<std::string> files;
+		for (int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "--seconds" && i + 1 < argc)
+				seconds = std::atof(argv[++i]);
+			else if (arg == "--dt" && i + 1 < argc)
+				dt = std::atof(argv[++i]);
+			else
+				files.push_back(arg);
+		}
+		if (files.empty())
+			files.push_back("testsave.txt");
+		if (seconds <= 0.0f || dt <= 0.0f)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		return Benchmarks::Simulate(files, seconds, dt);
+	}
+
+	if (benchmark == "expressions")
+	{
+		int emitters = argc > 2 ? std::atoi(argv[2]) : 1000;
+		int frames = argc > 3 ? std::atoi(argv[3]) : 600;
+		if (emitters <= 0 || frames <= 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		return Benchmarks::Expressions(emitters, frames);
+	}
+
+	if (benchmark == "layouts")
+	{
+		std::string file = argc > 2 ? argv[2] : "testsave.txt";
+		int particles = argc > 3 ? std::atoi(argv[3]) : 50000;
+		int steps = argc > 4 ? std::atoi(argv[4]) : 600;
+		if (particles <= 0 || steps <= 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		return Benchmarks::Layouts(file, (size_t)particles, steps);
+	}
+
+	if (benchmark == "threads")
+	{
+		std::string file = argc > 2 ? argv[2] : "testsave.txt";
+		int emitters = argc > 3 ? std::atoi(argv[3]) : 8;
+		int particles = argc > 4 ? std::atoi(argv[4]) : 50000;
+		int steps = argc > 5 ? std::atoi(argv[5]) : 600;
+		if (emitters <= 0 || particles <= 0 || steps <= 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		return Benchmarks::Threads(file, emitters, (size_t)particles, steps);
+	}
+
+	if (benchmark == "raster")
+	{
+		std::string file = argc > 2 ? argv[2] : "testsave.txt";
+		int particles = argc > 3 ? std::atoi(argv[3]) : 50000;
+		int width = argc > 4 ? std::atoi(argv[4]) : 1280;
+		int height = argc > 5 ? std::atoi(argv[5]) : 720;
+		int frames = argc > 6 ? std::atoi(argv[6]) : 60;
+		if (particles <= 0 || width <= 0 || height <= 0 || frames <= 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		return Benchmarks::Raster(file, (size_t)particles, width, height, frames);
+	}
+
+	PrintUsage();
+	return 1;
+}
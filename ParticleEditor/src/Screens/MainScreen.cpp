@@ -2,71 +2,402 @@
 
 #include "Utils/ParticleSerializer.h"
 #include "Utils/ConsoleLog.h"
+#include "Utils/FileLog.h"
+#include "Utils/RenderTarget.h"
+#include "Utils/ParticleRenderer.h"
+#include "Utils/SoftwareRasterizer.h"
+#include "Utils/FlipbookBaker.h"
+#include "Utils/Profiler.h"
+#include "Utils/Trace.h"
+#include "Utils/JobSystem.h"
+#include "Utils/IdleThrottle.h"
+#include "Utils/DynamicResolution.h"
+#include "Simulation/ParticleScene.h"
+#include "Simulation/SoaKernels.h"
+#include "Simulation/FixedTimestep.h"
+#include "Simulation/CheckpointTimeline.h"
+#include "Utils/EmitterBank.h"
+#include "Utils/EmitterExtras.h"
 
 #include <Difu/Particles/ParticleEmitter.h>
 #include <Difu/Utils/Logger.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <ctime>
 #include <fmt/core.h>
 #include <raylib.h>
+#include <rlgl.h>
 #include <rlImGui.h>
 #include <rlImGuiColors.h>
 #include <imgui.h>
 #include <imgui_stdlib.h>
 #include <string>
+#include <vector>
 #include <nfd.hpp>
 
 namespace MainScreen
 {
-	static ParticleEmitter emitter;
+	// Every emitter of the scene, the property editor edits the selected one
+	static std::vector<ParticleSerializer::SceneEmitter> emitters;
+	static size_t selected = 0;
+	static float elapsedTime = 0.0f;
+	// Fixed timestep mode runs the editor's own seeded simulation instead of Difu's emitters
+	static bool deterministic = false;
+	static int simulationSeed = 1;
+	// One system per emitter, all drawing from a single pool of particleBudget particles
+	static int particleBudget = (int)ParticlePool::DEFAULT_BUDGET;
+	static ParticleScene simulation;
+	static std::vector<EmitterSettings> stepSettings;
+	static FixedTimestep timestep;
+	static JobSystem jobs;
+	static int workerCount = 0;
+	static CheckpointTimeline checkpoints;
+	// Off once properties change mid-run, checkpoints from then on wouldn't match a run from 0
+	static bool recordCheckpoints = true;
+	static bool simulationPaused = false;
+	static bool scrubbing = false;
+	static float timelineLength = 30.0f;
+	// Prewarm left to simulate, spread over frames with at most prewarmBudget ms each
+	static constexpr float PREWARM_STEP = 1.0f / 30.0f;
+	static float prewarmRemaining = 0.0f;
+	static float prewarmBudget = 4.0f;
+	static std::string bindingSources[PropertyBindings::COUNT];
+	static std::string bindingErrors[PropertyBindings::COUNT];
 	static bool askSave = false;
 	static bool askOpen = false;
-	static RenderTexture2D viewportTexture;
+	// Rendered at viewportSize, times the dynamic resolution scale for the software renderer, and stretched to fit
+	static RenderTarget viewportTarget;
+	static DynamicResolution dynamicResolution;
+	static float viewportMilliseconds = 0.0f;
+	// How the fixed timestep simulation is drawn, Difu emitters always draw themselves
+	enum class ViewportRenderer
+	{
+		PerParticle,
+		Batched,
+		Software
+	};
+	static ViewportRenderer viewportRenderer = ViewportRenderer::Batched;
+	static ParticleRenderer particleRenderer;
+	static SoftwareRasterizer softwareRasterizer;
+	static Texture2D softwareTexture = {};
+	static float softwareMilliseconds = 0.0f;
+	// OpenGL values for rlSetBlendFactors, rlgl doesn't name them
+	static constexpr int GL_ONE_FACTOR = 1;
+	static constexpr int GL_ZERO_FACTOR = 0;
+	static constexpr int GL_ONE_MINUS_SRC_ALPHA_FACTOR = 0x0303;
+	static constexpr int GL_ADD_EQUATION = 0x8006;
+	// Baked sprite sheet of the selected emitter, played back next to the live viewport
+	static FlipbookBaker::Options flipbookOptions;
+	static FlipbookBaker::Flipbook flipbook;
+	static Texture2D flipbookTexture = {};
+	static RenderTarget flipbookTarget;
+	static float flipbookTime = 0.0f;
+	static float flipbookBakeMilliseconds = 0.0f;
 	static ImVec2 viewportPosition = { 0.0f, 0.0f };
 	static ImVec2 viewportSize = { 0.0f, 0.0f };
 	static bool viewportFocused = false;
+	// False while the Viewport tab is behind another one or collapsed
+	static bool viewportVisible = true;
+	static IdleThrottle idleThrottle;
+	// Pauses the simulation while nobody can see it
+	static bool simulateOnlyWhileVisible = true;
 	static ConsoleLog log;
+	static FileLog fileLog;
+	static EmitterBank openBank;
+	static bool propertiesChanged = false;
+	static bool showStats = false;
+	static bool showProfiler = false;
+	static bool showTimeline = true;
+	static bool showScene = true;
+	static bool showFlipbook = false;
 
+	// Logger may be called from worker threads, both sinks are thread safe
 	static void PrintFunction(std::string value)
 	{
-		log.Print(value);
+		fileLog.Print(value);
+		log.Print(std::move(value));
+	}
+
+	static bool HasExtension(const std::string& filename, const std::string& extension)
+	{
+		return filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+	}
+
+	static void InvalidateCheckpoints()
+	{
+		checkpoints.Clear();
+		recordCheckpoints = false;
+	}
+
+	static ParticleSerializer::SceneEmitter& Selected()
+	{
+		return emitters[selected];
+	}
+
+	static void SetSpawnPosition(size_t index, Vector2 position)
+	{
+		ParticleSerializer::SceneEmitter& entry = emitters[index];
+		if (position.x != entry.position.x || position.y != entry.position.y)
+			InvalidateCheckpoints();
+		entry.position = position;
+		entry.emitter.SetSpawnPosition(position);
+	}
+
+	static void RestartSimulation()
+	{
+		elapsedTime = 0.0f;
+		simulation.Reset(simulationSeed);
+		timestep.Reset();
+		checkpoints.Clear();
+		recordCheckpoints = true;
+		checkpoints.Record(simulation);
+		// The run starts from the current properties, earlier edits don't invalidate it
+		propertiesChanged = false;
+	}
+
+	static void StepSimulation(int steps)
+	{
+		stepSettings.resize(emitters.size());
+		for (int i = 0; i < steps; i++)
+		{
+			// Bindings are evaluated at the step's own time so the result doesn't depend on the frame rate
+			float time = (float)simulation.GetTime();
+			for (size_t e = 0; e < emitters.size(); e++)
+			{
+				emitters[e].extras.bindings.Apply(&emitters[e].emitter, time);
+				stepSettings[e] = EmitterSettings::FromEmitter(emitters[e].emitter, emitters[e].position);
+			}
+			simulation.Step(stepSettings.data(), timestep.GetStep(), &jobs);
+			if (recordCheckpoints)
+				checkpoints.Record(simulation);
+		}
+		elapsedTime = (float)simulation.GetTime();
+	}
+
+	// Difu's emitters spawn through raylib's GetRandomValue, which shares rand()'s global
+	// state, so they stay on the main thread. Only the fixed timestep simulation is parallel.
+	static void UpdateEmitters(float dt)
+	{
+		for (ParticleSerializer::SceneEmitter& entry : emitters)
+			entry.emitter.Update(dt);
+	}
+
+	// Restores the nearest checkpoint and simulates the rest
+	static void SeekSimulation(double target)
+	{
+		TRACE_SCOPE("SeekSimulation");
+
+		target = std::max(target, 0.0);
+		if (target < simulation.GetTime() || checkpoints.GetLatestTime() > simulation.GetTime())
+		{
+			if (!checkpoints.Restore(target, &simulation))
+				RestartSimulation();
+		}
+
+		StepSimulation((int)std::lround((target - simulation.GetTime()) / timestep.GetStep()));
+		timestep.Reset();
+	}
+
+	// The scene prewarms as a whole, for as long as its longest emitter asks for
+	static void StartPrewarm()
+	{
+		prewarmRemaining = 0.0f;
+		for (const ParticleSerializer::SceneEmitter& entry : emitters)
+			prewarmRemaining = std::max(prewarmRemaining, entry.extras.prewarm);
+	}
+
+	// Render-free fast forward. Difu's emitters take coarse steps, the
+	// deterministic simulation takes its normal ones so it stays reproducible.
+	static void RunPrewarm()
+	{
+		TRACE_SCOPE("Prewarm");
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::chrono::duration<float, std::milli> budget(prewarmBudget);
+		while (prewarmRemaining > 0.0f && std::chrono::steady_clock::now() - start < budget)
+		{
+			if (deterministic)
+			{
+				StepSimulation(1);
+				prewarmRemaining -= timestep.GetStep();
+			}
+			else
+			{
+				float step = std::min(PREWARM_STEP, prewarmRemaining);
+				elapsedTime += step;
+				for (ParticleSerializer::SceneEmitter& entry : emitters)
+					entry.extras.bindings.Apply(&entry.emitter, elapsedTime);
+				UpdateEmitters(step);
+				prewarmRemaining -= step;
+			}
+		}
+	}
+
+	static void Select(size_t index)
+	{
+		selected = std::min(index, emitters.size() - 1);
+		for (int i = 0; i < PropertyBindings::COUNT; i++)
+		{
+			bindingSources[i] = Selected().extras.bindings.GetExpression((BindingTarget)i).GetSource();
+			bindingErrors[i].clear();
+		}
+	}
+
+	static void OnEmitterLoaded()
+	{
+		RestartSimulation();
+		StartPrewarm();
+		Select(selected);
+	}
+
+	static ParticleEmitter CreateDefaultEmitter()
+	{
+		return ParticleEmitter({0.0f, 0.0f}, {100.0f, 0.0f}, {0.0f, 0.0f}, 0.0f, 0.0f, 0.0f, 0.0f, BLACK, WHITE, {1.0f, 1.0f}, 1.0f, 20.0f, 1.0f, 0.1f, 1.0f, 2 * PI);
+	}
+
+	// Systems follow the emitter list index for index
+	static void AddEmitter(ParticleSerializer::SceneEmitter entry)
+	{
+		entry.emitter.SetSpawnPosition(entry.position);
+		entry.emitter.StartEmitting();
+		emitters.push_back(std::move(entry));
+		simulation.Add();
+	}
+
+	static void RemoveEmitter(size_t index)
+	{
+		// The property editor always needs one to edit
+		if (emitters.size() <= 1 || index >= emitters.size())
+			return;
+		emitters.erase(emitters.begin() + index);
+		simulation.Remove(index);
+		Select(selected > index ? selected - 1 : selected);
+		RestartSimulation();
+	}
+
+	static void SetParticleBudget(int budget)
+	{
+		particleBudget = std::max(budget, 1);
+		simulation.SetBudget((size_t)particleBudget);
+		RestartSimulation();
+	}
+
+	static void LoadScene(std::vector<ParticleSerializer::SceneEmitter>& loaded, size_t budget)
+	{
+		while (simulation.GetCount() > 0)
+			simulation.Remove(simulation.GetCount() - 1);
+		emitters.clear();
+
+		for (ParticleSerializer::SceneEmitter& entry : loaded)
+			AddEmitter(std::move(entry));
+		selected = 0;
+		SetParticleBudget((int)std::min<size_t>(budget, INT32_MAX));
+		OnEmitterLoaded();
 	}
 
 
 	static void Load()
 	{
 		log.Load({10.0f, GetScreenHeight() - 310.0f, 300.0f, 300.0f}, 7.0f, {123, 201, 34, 255});
+		// Keeps messages around after they fade out of the console. Opened before binding so none are dropped.
+		fileLog.Open("ParticleEditor.log");
 		Logger::Bind(&PrintFunction);
-		Particle baseParticle;
-		baseParticle.lifetime = 1.0f;
-		baseParticle.velocity = {100.0f, 0.0f};
-		emitter = ParticleEmitter({0.0f, 0.0f}, {100.0f, 0.0f}, {0.0f, 0.0f}, 0.0f, 0.0f, 0.0f, 0.0f, BLACK, WHITE, {1.0f, 1.0f}, 1.0f, 20.0f, 1.0f, 0.1f, 1.0f, 2 * PI);
-		emitter.StartEmitting();
+		Trace::SetThreadName("Main");
+		workerCount = (int)JobSystem::GetDefaultWorkerCount();
+		jobs.Start(workerCount);
+		ParticleSerializer::SceneEmitter entry;
+		entry.emitter = CreateDefaultEmitter();
+		AddEmitter(std::move(entry));
+		RestartSimulation();
 
 		SetExitKey(0);
 
 		NFD::Init();
 		rlImGuiSetup(false);
 		ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+		particleRenderer.Load();
 	}
 
 	static void Unload()
 	{
+		jobs.Stop();
 		rlImGuiShutdown();
+		particleRenderer.Unload();
+		if (softwareTexture.id)
+			UnloadTexture(softwareTexture);
+		if (flipbookTexture.id)
+			UnloadTexture(flipbookTexture);
+		flipbookTarget.Unload();
+		openBank.Close();
+		viewportTarget.Unload();
 		log.Unload();
+		fileLog.Close();
 		NFD::Quit();
 	}
 
-	// static float t = 0.0f;
+	// Difu doesn't expose its particles, steady state count from the spawn interval and lifetime
+	static size_t EstimateLiveParticles()
+	{
+		size_t count = 0;
+		for (const ParticleSerializer::SceneEmitter& entry : emitters)
+		{
+			float interval = entry.emitter.GetSpawnInterval();
+			if (interval > 0.0f)
+				count += (size_t)(std::min(elapsedTime, entry.emitter.GetParticleLifetime()) / interval);
+		}
+		return count;
+	}
 
 	static void Update(float dt)
 	{
-		// t += dt;
-		// emitter.SetCentripetalAcceleration(std::sin(t) * 200);
-		// TODO: Add feature to bind value to a finction of time
+		if (Profiler::ENABLED)
+			Profiler::NewFrame(dt);
+		PROFILE_SCOPE(Update);
+		TRACE_SCOPE("Update");
+
+		bool visible = viewportVisible && !IsWindowMinimized() && !IsWindowHidden();
+		bool simulating = visible || !simulateOnlyWhileVisible;
+		// Paused fixed timestep mode only changes when something is edited, which counts as input
+		bool animating = prewarmRemaining > 0.0f || (visible && !(deterministic && simulationPaused)) || (showFlipbook && flipbook.frameCount > 0);
+		idleThrottle.Update(dt, animating);
+
+		if (prewarmRemaining > 0.0f)
+		{
+			PROFILE_SCOPE(EmitterUpdate);
+			RunPrewarm();
+		}
+		else if (deterministic)
+		{
+			if (propertiesChanged)
+				InvalidateCheckpoints();
 
-		emitter.Update(dt);
+			PROFILE_SCOPE(EmitterUpdate);
+			if (!simulationPaused && !scrubbing && simulating)
+				StepSimulation(timestep.Advance(dt));
+		}
+		else if (simulating)
+		{
+			elapsedTime += dt;
+			for (ParticleSerializer::SceneEmitter& entry : emitters)
+				entry.extras.bindings.Apply(&entry.emitter, elapsedTime);
+
+			PROFILE_SCOPE(EmitterUpdate);
+			UpdateEmitters(dt);
+		}
+		// Every job has finished once ParticleScene::Step returns, so RenderViewport never sees a half updated system
+
+		if (Profiler::ENABLED)
+		{
+			if (deterministic)
+				Profiler::SetParticleCount(simulation.GetParticleCount());
+			else
+				Profiler::SetParticleCount(EstimateLiveParticles(), true);
+		}
 		log.Update(dt);
+		if (flipbook.frameCount > 0)
+			flipbookTime = std::fmod(flipbookTime + dt, flipbook.period);
 
 		bool ctrl = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
 
@@ -80,142 +411,618 @@ namespace MainScreen
 		if (viewportFocused && CheckCollisionPointRec(GetMousePosition(), {viewportPosition.x, viewportPosition.y, viewportSize.x, viewportSize.y}) && IsMouseButtonDown(MOUSE_LEFT_BUTTON))
 		{
 			SetMouseOffset(-viewportPosition.x, -viewportPosition.y);
-			emitter.SetSpawnPosition(GetMousePosition());
+			SetSpawnPosition(selected, GetMousePosition());
 			SetMouseOffset(0, 0);
 		}
 	}
 
-	static void RenderViewport()
+	// Rasterizes on the job system's workers and shows the result through a texture
+	static void RenderSoftware()
 	{
-		BeginTextureMode(viewportTexture);
-		ClearBackground(WHITE);
-		emitter.Render();
-		EndTextureMode();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		softwareRasterizer.Resize(viewportTarget.GetWidth(), viewportTarget.GetHeight());
+		softwareRasterizer.Begin(WHITE, false, dynamicResolution.GetScale());
+		for (size_t i = 0; i < emitters.size(); i++)
+			softwareRasterizer.Add(simulation.GetSystem(i), EmitterSettings::FromEmitter(emitters[i].emitter, emitters[i].position), timestep.GetAlpha());
+		softwareRasterizer.End(&jobs);
+		softwareMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		int width = softwareRasterizer.GetWidth();
+		int height = softwareRasterizer.GetHeight();
+		if (softwareTexture.width != width || softwareTexture.height != height)
+		{
+			if (softwareTexture.id)
+				UnloadTexture(softwareTexture);
+			Image image = {(void*)softwareRasterizer.GetPixels(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+			softwareTexture = LoadTextureFromImage(image);
+		}
+		else
+			UpdateTexture(softwareTexture, softwareRasterizer.GetPixels());
+
+		// Copied as is, blending would change its alpha and break the comparison with the GPU
+		rlSetBlendFactors(GL_ONE_FACTOR, GL_ZERO_FACTOR, GL_ADD_EQUATION);
+		BeginBlendMode(BLEND_CUSTOM);
+		DrawTexture(softwareTexture, 0, 0, WHITE);
+		EndBlendMode();
 	}
 
-	static void OnViewportResize(int width, int height)
+	static void RenderViewport()
 	{
-		emitter.SetSpawnPosition({width / 2.0f, height / 2.0f});
+		PROFILE_SCOPE(RenderViewport);
+		TRACE_SCOPE("RenderViewport");
 
-		UnloadRenderTexture(viewportTexture);
-		viewportTexture = LoadRenderTexture(width, height);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		// Only the software renderer scales. The GPU paths submit asynchronously, so their fill
+		// cost never shows up in a CPU timer, and the per particle ones cost time per particle.
+		bool software = prewarmRemaining <= 0.0f && deterministic && viewportRenderer == ViewportRenderer::Software;
+		float scale = software ? dynamicResolution.GetScale() : 1.0f;
+		// Only reallocates when the viewport outgrows the texture or gets much smaller
+		viewportTarget.Resize((int)std::lround(viewportSize.x * scale), (int)std::lround(viewportSize.y * scale));
 
-		RenderViewport();
-		log.SetDestinationBounds({10.0f, height - 310.0f, (float)width - 20.0f, 300.0f});
+		particleRenderer.ResetStats();
+		viewportTarget.Begin();
+		ClearBackground(WHITE);
+		if (prewarmRemaining > 0.0f)
+			DrawText(TextFormat("Prewarming, %.1f s left", prewarmRemaining), 10, 10, 20, GRAY);
+		else if (software)
+		{
+			PROFILE_SCOPE(EmitterRender);
+			RenderSoftware();
+		}
+		else if (deterministic && viewportRenderer == ViewportRenderer::Batched && particleRenderer.IsSupported())
+		{
+			// One instanced draw for the whole scene
+			PROFILE_SCOPE(EmitterRender);
+			particleRenderer.Begin();
+			for (size_t i = 0; i < emitters.size(); i++)
+				particleRenderer.Add(simulation.GetSystem(i), EmitterSettings::FromEmitter(emitters[i].emitter, emitters[i].position), timestep.GetAlpha());
+			particleRenderer.End();
+		}
+		else
+		{
+			PROFILE_SCOPE(EmitterRender);
+			for (size_t i = 0; i < emitters.size(); i++)
+			{
+				if (deterministic)
+					simulation.GetSystem(i).Render(EmitterSettings::FromEmitter(emitters[i].emitter, emitters[i].position), timestep.GetAlpha());
+				else
+					emitters[i].emitter.Render();
+			}
+		}
+		viewportTarget.End();
+
+		viewportMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (software)
+			dynamicResolution.Update(GetFrameTime(), softwareMilliseconds);
 	}
 
-	static void Render()
+	static void BakeFlipbook()
 	{
-		ClearBackground(WHITE);
-		
-		RenderViewport();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!FlipbookBaker::Bake(Selected().emitter, Selected().extras, flipbookOptions, &jobs, &flipbook))
+			return;
+		flipbookBakeMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		flipbookTime = 0.0f;
 
-		rlImGuiBegin();
+		if (flipbookTexture.id)
+			UnloadTexture(flipbookTexture);
+		Image image = {(void*)flipbook.atlas.data(), flipbook.GetAtlasWidth(), flipbook.GetAtlasHeight(), 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+		flipbookTexture = LoadTextureFromImage(image);
+		flipbookTarget.Resize(flipbook.frameWidth, flipbook.frameHeight);
+	}
 
-		// Menu Bar
-		if (ImGui::BeginMainMenuBar())
-		{
-			if (ImGui::BeginMenu("File"))
-			{
-				if (ImGui::MenuItem("Save", "ctrl+s"))
-					askSave = true;
+	// Current frame of the flipbook over the viewport's background
+	static void RenderFlipbookPreview()
+	{
+		TRACE_SCOPE("RenderFlipbookPreview");
 
-				if (ImGui::MenuItem("Open", "ctrl+o"))
-					askOpen = true;
+		int frame = std::min((int)(flipbookTime / flipbook.period * flipbook.frameCount), flipbook.frameCount - 1);
+		flipbookTarget.Begin();
+		ClearBackground(WHITE);
+		// The atlas is premultiplied
+		rlSetBlendFactors(GL_ONE_FACTOR, GL_ONE_MINUS_SRC_ALPHA_FACTOR, GL_ADD_EQUATION);
+		BeginBlendMode(BLEND_CUSTOM);
+		DrawTextureRec(flipbookTexture, flipbook.GetFrameRect(frame), {0.0f, 0.0f}, WHITE);
+		EndBlendMode();
+		flipbookTarget.End();
+	}
 
-				ImGui::EndMenu();
-			}
-			ImGui::EndMainMenuBar();
-		}
+	// Called before viewportSize changes, the texture follows in RenderViewport
+	static void OnViewportResize(int width, int height)
+	{
+		// Emitters keep their place relative to the center, the first layout centers the default one
+		Vector2 shift = {(width - viewportSize.x) / 2.0f, (height - viewportSize.y) / 2.0f};
+		for (size_t i = 0; i < emitters.size(); i++)
+			SetSpawnPosition(i, {emitters[i].position.x + shift.x, emitters[i].position.y + shift.y});
 
-		// Dockspace
-		ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
+		log.SetDestinationBounds({10.0f, height - 310.0f, (float)width - 20.0f, 300.0f});
+	}
 
-		// Viewport
-		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
-		ImGui::Begin("Viewport");
-		ImVec2 viewportNewSize = ImGui::GetContentRegionAvail();
-		if (viewportNewSize.x != viewportSize.x || viewportNewSize.y != viewportSize.y)
-		{
-			viewportSize = viewportNewSize;
-			OnViewportResize(viewportSize.x, viewportSize.y);
-		}
-		rlImGuiImageRect(&viewportTexture.texture, viewportSize.x, viewportSize.y, {0.0f, 0.0f, viewportSize.x, -viewportSize.y});
-		viewportFocused = ImGui::IsWindowFocused();
-		viewportPosition = ImGui::GetWindowPos();
-		ImGui::End();
-		ImGui::PopStyleVar();
-		
+	// Properties
+	static void RenderPropertyEditor()
+	{
+		PROFILE_SCOPE(PropertyEditor);
 
-		// Properties
+		// Setters only run when a widget reports an edit
+		propertiesChanged = false;
 		ImGui::Begin("Property editor");
 
+		ParticleEmitter& emitter = Selected().emitter;
+		EmitterExtras& extras = Selected().extras;
+		ImGui::TextDisabled("Editing %s", Selected().name.empty() ? "unnamed emitter" : Selected().name.c_str());
+
 		float lifetime = emitter.GetParticleLifetime();
-		ImGui::DragFloat("Lifetime", &lifetime, 0.01f);	
-		emitter.SetParticleLifetime(lifetime);
+		if (ImGui::DragFloat("Lifetime", &lifetime, 0.01f))
+		{
+			emitter.SetParticleLifetime(lifetime);
+			propertiesChanged = true;
+		}
 
 		Vector2 particleResolution = emitter.GetParticleResolution();
-		ImGui::DragFloat2("Resolution", &particleResolution.x, 0.01f);
-		emitter.SetParticleResolution(particleResolution);
+		if (ImGui::DragFloat2("Resolution", &particleResolution.x, 0.01f))
+		{
+			emitter.SetParticleResolution(particleResolution);
+			propertiesChanged = true;
+		}
 
 		float minSizeFactor = emitter.GetParticleMinSizeFactor();
-		ImGui::InputFloat("Min. Size Factor", &minSizeFactor, 0.01);
-		emitter.SetParticleMinSizeFactor(minSizeFactor);
+		if (ImGui::InputFloat("Min. Size Factor", &minSizeFactor, 0.01))
+		{
+			emitter.SetParticleMinSizeFactor(minSizeFactor);
+			propertiesChanged = true;
+		}
 
 		float maxSizeFactor = emitter.GetParticleMaxSizeFactor();
-		ImGui::InputFloat("Max. Size Factor", &maxSizeFactor, 0.01);
-		emitter.SetParticleMaxSizeFactor(maxSizeFactor);
+		if (ImGui::InputFloat("Max. Size Factor", &maxSizeFactor, 0.01))
+		{
+			emitter.SetParticleMaxSizeFactor(maxSizeFactor);
+			propertiesChanged = true;
+		}
 
 		Vector2 particleVelocity = emitter.GetSpawnVelocity();
-		ImGui::InputFloat2("Velocity", &particleVelocity.x);
-		emitter.SetSpawnVelocity(particleVelocity);
+		if (ImGui::InputFloat2("Velocity", &particleVelocity.x))
+		{
+			emitter.SetSpawnVelocity(particleVelocity);
+			propertiesChanged = true;
+		}
 
 		Vector2 particleAcceleration = emitter.GetParticleAcceleration();
-		ImGui::InputFloat2("Acceleration", &particleAcceleration.x);
-		emitter.SetParticleAcceleration(particleAcceleration);
+		if (ImGui::InputFloat2("Acceleration", &particleAcceleration.x))
+		{
+			emitter.SetParticleAcceleration(particleAcceleration);
+			propertiesChanged = true;
+		}
 
 		float centripetalAcceleration = emitter.GetCentripetalAcceleration();
-		ImGui::InputFloat("Centripetal Acceleration", &centripetalAcceleration, 0.01f);
-		emitter.SetCentripetalAcceleration(centripetalAcceleration);
+		if (ImGui::InputFloat("Centripetal Acceleration", &centripetalAcceleration, 0.01f))
+		{
+			emitter.SetCentripetalAcceleration(centripetalAcceleration);
+			propertiesChanged = true;
+		}
 		
 		float particleRotation = emitter.GetParticleSpawnRotation();
-		ImGui::InputFloat("Rotation", &particleRotation, 0.01f);
-		emitter.SetParticleSpawnRotation(particleRotation);
+		if (ImGui::InputFloat("Rotation", &particleRotation, 0.01f))
+		{
+			emitter.SetParticleSpawnRotation(particleRotation);
+			propertiesChanged = true;
+		}
 
 		float particleRotationVelocity = emitter.GetParticleSpawnRotationVelocity();
-		ImGui::InputFloat("Rotational Velocity", &particleRotationVelocity, 0.01f);
-		emitter.SetParticleSpawnRotationVelocity(particleRotationVelocity);
+		if (ImGui::InputFloat("Rotational Velocity", &particleRotationVelocity, 0.01f))
+		{
+			emitter.SetParticleSpawnRotationVelocity(particleRotationVelocity);
+			propertiesChanged = true;
+		}
 
 		float rotationAcceleration = emitter.GetParticleRotationAcceleration();
-		ImGui::InputFloat("Rotational Acceleration", &rotationAcceleration, 0.01f);
-		emitter.SetParticleRotationAcceleration(rotationAcceleration);
+		if (ImGui::InputFloat("Rotational Acceleration", &rotationAcceleration, 0.01f))
+		{
+			emitter.SetParticleRotationAcceleration(rotationAcceleration);
+			propertiesChanged = true;
+		}
 
-		Color startColor = emitter.GetStartColor();
-		ImVec4 imStartColor = rlImGuiColors::Convert(startColor);
-		ImGui::ColorEdit4("Start Color", &imStartColor.x);
-		startColor = rlImGuiColors::Convert(imStartColor);
-		emitter.SetStartColor(startColor);
+		ImVec4 imStartColor = rlImGuiColors::Convert(emitter.GetStartColor());
+		if (ImGui::ColorEdit4("Start Color", &imStartColor.x))
+		{
+			emitter.SetStartColor(rlImGuiColors::Convert(imStartColor));
+			propertiesChanged = true;
+		}
 
-		Color endColor = emitter.GetEndColor();
-		ImVec4 imEndColor = rlImGuiColors::Convert(endColor);
-		ImGui::ColorEdit4("End Color", &imEndColor.x);
-		endColor = rlImGuiColors::Convert(imEndColor);
-		emitter.SetEndColor(endColor);
+		ImVec4 imEndColor = rlImGuiColors::Convert(emitter.GetEndColor());
+		if (ImGui::ColorEdit4("End Color", &imEndColor.x))
+		{
+			emitter.SetEndColor(rlImGuiColors::Convert(imEndColor));
+			propertiesChanged = true;
+		}
 
 		float spawnInterval = emitter.GetSpawnInterval();
-		ImGui::InputFloat("Interval", &spawnInterval);
-		if (spawnInterval > 0.0f)
-			emitter.SetSpawnInterval(spawnInterval);
+		if (ImGui::InputFloat("Interval", &spawnInterval) && spawnInterval > 0.0f)
+		{
+			// Difu's emitters spawn in the same kind of loop
+			emitter.SetSpawnInterval(std::max(spawnInterval, EmitterSettings::MIN_SPAWN_INTERVAL));
+			propertiesChanged = true;
+		}
 
 		float randomness = emitter.GetRandomness();
-		ImGui::InputFloat("Randomness", &randomness);
-		emitter.SetRandomness(randomness);
+		if (ImGui::InputFloat("Randomness", &randomness))
+		{
+			emitter.SetRandomness(randomness);
+			propertiesChanged = true;
+		}
 
 		float spread = emitter.GetSpread();
-		ImGui::InputFloat("Spread", &spread);
-		emitter.SetSpread(spread);
+		if (ImGui::InputFloat("Spread", &spread))
+		{
+			emitter.SetSpread(spread);
+			propertiesChanged = true;
+		}
+
+		// Not an emitter property, only used when loading, so no propertiesChanged
+		ImGui::DragFloat("Prewarm (s)", &extras.prewarm, 0.05f, 0.0f, 120.0f);
+
+		if (ImGui::CollapsingHeader("Time bindings"))
+		{
+			ImGui::TextDisabled("Drive a property with a function of t, e.g. sin(t) * 200");
+			for (int i = 0; i < PropertyBindings::COUNT; i++)
+			{
+				BindingTarget target = (BindingTarget)i;
+				ImGui::PushID(i);
+				if (ImGui::InputTextWithHint(PropertyBindings::GetName(target), "not bound", &bindingSources[i]))
+				{
+					bindingErrors[i].clear();
+					if (extras.bindings.Bind(target, bindingSources[i], &bindingErrors[i]))
+						propertiesChanged = true;
+				}
+				if (!bindingErrors[i].empty())
+					ImGui::TextColored({0.9f, 0.2f, 0.2f, 1.0f}, "%s", bindingErrors[i].c_str());
+				ImGui::PopID();
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Simulation"))
+		{
+			if (ImGui::Checkbox("Fixed timestep (deterministic)", &deterministic))
+			{
+				RestartSimulation();
+				StartPrewarm();
+			}
+			ImGui::TextDisabled("Runs a seeded simulation with fixed steps, the same seed always gives the same particles");
+			ImGui::DragFloat("Prewarm budget", &prewarmBudget, 0.1f, 0.5f, 16.0f, "%.1f ms/frame");
+			// Updates emitters, and chunks of large ones, in parallel. 0 runs everything on the main thread.
+			// Restarting the threads while dragging would stall every frame
+			ImGui::SliderInt("Worker threads", &workerCount, 0, 31);
+			if (ImGui::IsItemDeactivatedAfterEdit())
+			{
+				workerCount = std::clamp(workerCount, 0, 31);
+				jobs.Start(workerCount);
+			}
+
+			bool throttle = idleThrottle.IsEnabled();
+			if (ImGui::Checkbox("Lower FPS when idle", &throttle))
+				idleThrottle.SetEnabled(throttle);
+			ImGui::SameLine();
+			ImGui::Checkbox("Simulate only while visible", &simulateOnlyWhileVisible);
+
+			// Rasterizes the viewport at a lower resolution while it takes longer than the target
+			bool scaleResolution = dynamicResolution.IsEnabled();
+			if (ImGui::Checkbox("Dynamic resolution", &scaleResolution))
+				dynamicResolution.SetEnabled(scaleResolution);
+			if (scaleResolution)
+			{
+				ImGui::SameLine();
+				ImGui::Text("%.0f%%", dynamicResolution.GetScale() * 100.0f);
+				float target = dynamicResolution.GetTargetMilliseconds();
+				if (ImGui::DragFloat("Raster time target", &target, 0.1f, 0.5f, 33.0f, "%.1f ms"))
+					dynamicResolution.SetTargetMilliseconds(target);
+				if (!deterministic || viewportRenderer != ViewportRenderer::Software)
+					ImGui::TextDisabled("Only applies to the software renderer");
+			}
+
+			if (deterministic)
+			{
+				float stepRate = 1.0f / timestep.GetStep();
+				if (ImGui::DragFloat("Steps per second", &stepRate, 1.0f, 10.0f, 1000.0f, "%.0f"))
+					timestep.SetStep(1.0f / stepRate);
+
+				int maxSubsteps = timestep.GetMaxSubsteps();
+				if (ImGui::SliderInt("Max substeps per frame", &maxSubsteps, 1, 16))
+					timestep.SetMaxSubsteps(maxSubsteps);
+
+				// Every layout and kernel gives the same particles, only the speed differs
+				static const char* LAYOUT_NAMES[] = {"Array of structs", "Structure of arrays (SIMD)"};
+				int layout = (int)simulation.GetPool().GetLayout();
+				if (ImGui::Combo("Particle storage", &layout, LAYOUT_NAMES, IM_ARRAYSIZE(LAYOUT_NAMES)))
+				{
+					simulation.SetLayout((ParticleLayout)layout);
+					RestartSimulation();
+				}
+				if (simulation.GetPool().GetLayout() == ParticleLayout::StructOfArrays && ImGui::BeginCombo("Kernel", SoaKernels::GetName(SoaKernels::GetLevel())))
+				{
+					for (int i = 0; i <= (int)SoaKernels::GetSupportedLevel(); i++)
+					{
+						SoaKernels::Level level = (SoaKernels::Level)i;
+						if (ImGui::Selectable(SoaKernels::GetName(level), level == SoaKernels::GetLevel()))
+							SoaKernels::SetLevel(level);
+					}
+					ImGui::EndCombo();
+				}
+
+				static const char* RENDERER_NAMES[] = {"Per particle", "Batched (GPU instancing)", "Software (CPU tiles)"};
+				int renderer = (int)viewportRenderer;
+				if (ImGui::Combo("Renderer", &renderer, RENDERER_NAMES, IM_ARRAYSIZE(RENDERER_NAMES)))
+					viewportRenderer = (ViewportRenderer)renderer;
+				if (viewportRenderer == ViewportRenderer::Batched && !particleRenderer.IsSupported())
+					ImGui::TextDisabled("Needs OpenGL 3.3, drawing per particle");
+
+				if (ImGui::InputInt("Seed", &simulationSeed))
+					RestartSimulation();
+				if (ImGui::Button("Restart"))
+				{
+					RestartSimulation();
+					StartPrewarm();
+				}
+
+				ImGui::Text("Time: %.3f s, %zu particles", simulation.GetTime(), simulation.GetParticleCount());
+				ImGui::Text("State hash: %016llx", (unsigned long long)simulation.GetStateHash());
+				if (timestep.GetDroppedTime() > 0.0)
+					ImGui::Text("Dropped %.3f s to slow frames", timestep.GetDroppedTime());
+			}
+		}
 
 		ImGui::End();
+	}
+
+	static void RenderTimeline()
+	{
+		scrubbing = false;
+		if (!ImGui::Begin("Timeline", &showTimeline))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!deterministic)
+		{
+			ImGui::TextDisabled("Scrubbing needs fixed timestep mode, see Simulation in the property editor");
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Checkbox("Paused", &simulationPaused);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		float time = (float)simulation.GetTime();
+		timelineLength = std::max(timelineLength, time);
+		if (ImGui::SliderFloat("##Time", &time, 0.0f, timelineLength, "%.2f s"))
+			SeekSimulation(time);
+		scrubbing = ImGui::IsItemActive();
+
+		ImGui::DragFloat("Length", &timelineLength, 1.0f, 1.0f, 3600.0f, "%.0f s");
+		ImGui::Text("%zu checkpoints every %.2f s, %.1f KiB", checkpoints.GetCount(), checkpoints.GetInterval(), checkpoints.GetMemory() / 1024.0f);
+		if (!recordCheckpoints)
+			ImGui::TextDisabled("Properties changed, seeking back replays from 0 with the current ones");
+
+		ImGui::End();
+	}
+
+	static void RenderScene()
+	{
+		if (!ImGui::Begin("Scene", &showScene))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (ImGui::Button("Add"))
+		{
+			ParticleSerializer::SceneEmitter entry;
+			entry.emitter = CreateDefaultEmitter();
+			entry.position = {viewportSize.x / 2.0f, viewportSize.y / 2.0f};
+			AddEmitter(std::move(entry));
+			Select(emitters.size() - 1);
+			RestartSimulation();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Duplicate"))
+		{
+			ParticleSerializer::SceneEmitter entry = Selected();
+			entry.name += " copy";
+			AddEmitter(std::move(entry));
+			Select(emitters.size() - 1);
+			RestartSimulation();
+		}
+		ImGui::SameLine();
+		ImGui::BeginDisabled(emitters.size() <= 1);
+		if (ImGui::Button("Remove"))
+			RemoveEmitter(selected);
+		ImGui::EndDisabled();
+
+		if (ImGui::BeginListBox("##Emitters", {-FLT_MIN, 0.0f}))
+		{
+			for (size_t i = 0; i < emitters.size(); i++)
+			{
+				ImGui::PushID((int)i);
+				const std::string& name = emitters[i].name;
+				if (ImGui::Selectable(name.empty() ? TextFormat("Emitter %zu", i + 1) : name.c_str(), i == selected))
+					Select(i);
+				ImGui::PopID();
+			}
+			ImGui::EndListBox();
+		}
+
+		// Reallocating restarts the simulation, so only once the edit is done
+		static int budgetEdit = particleBudget;
+		ImGui::InputInt("Particle budget", &budgetEdit, 1000, 10000);
+		if (ImGui::IsItemDeactivatedAfterEdit())
+			SetParticleBudget(budgetEdit);
+		else if (!ImGui::IsItemActive())
+			budgetEdit = particleBudget;
+
+		const ParticlePool& pool = simulation.GetPool();
+		ImGui::Text("%zu / %zu particles, %.1f MiB", simulation.GetParticleCount(), pool.GetCapacity(), pool.GetMemory() / (1024.0f * 1024.0f));
+		ImGui::Text("%zu of %zu blocks free", pool.GetFreeBlockCount(), pool.GetBlockCount());
+		if (!deterministic)
+			ImGui::TextDisabled("The shared pool is used in fixed timestep mode, Difu's emitters keep their own particles");
+
+		ImGui::End();
+	}
+
+	static void RenderFlipbook()
+	{
+		if (!ImGui::Begin("Flipbook", &showFlipbook))
+		{
+			ImGui::End();
+			return;
+		}
+
+		int frameSize[2] = {flipbookOptions.frameWidth, flipbookOptions.frameHeight};
+		if (ImGui::InputInt2("Frame size", frameSize))
+		{
+			flipbookOptions.frameWidth = std::clamp(frameSize[0], 1, 2048);
+			flipbookOptions.frameHeight = std::clamp(frameSize[1], 1, 2048);
+		}
+		if (ImGui::InputInt("Frames", &flipbookOptions.frameCount))
+			flipbookOptions.frameCount = std::clamp(flipbookOptions.frameCount, 1, 256);
+		if (ImGui::DragFloat("Period", &flipbookOptions.period, 0.05f, 0.0f, 60.0f, flipbookOptions.period > 0.0f ? "%.2f s" : "Lifetime"))
+			flipbookOptions.period = std::max(flipbookOptions.period, 0.0f);
+		if (ImGui::Button("Bake selected emitter"))
+			BakeFlipbook();
+
+		if (flipbook.frameCount == 0)
+		{
+			ImGui::End();
+			return;
+		}
+
+		ImGui::SameLine();
+		ImGui::Text("%.1f ms", flipbookBakeMilliseconds);
+		ImGui::Text("%d frames of %dx%d over %.2f s, %dx%d atlas", flipbook.frameCount, flipbook.frameWidth, flipbook.frameHeight, flipbook.period, flipbook.GetAtlasWidth(), flipbook.GetAtlasHeight());
+		ImGui::Text("Baked: %.1f KiB of texture, one quad per frame", flipbook.GetAtlasMemory() / 1024.0f);
+		ImGui::Text("Live: up to %zu particles, %.1f KiB, %.2f us per step", flipbook.peakParticles, flipbook.peakParticleMemory / 1024.0f, flipbook.stepMicroseconds);
+
+		static std::string filenameBuf;
+		bool entered = ImGui::InputTextWithHint("Filename", "flipbook.png", &filenameBuf, ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_EscapeClearsAll);
+		ImGui::SameLine();
+		if ((ImGui::Button("Export") || entered) && !filenameBuf.empty())
+			FlipbookBaker::Save(filenameBuf, flipbook);
+
+		const Texture2D& previewTexture = flipbookTarget.GetTexture();
+		float usedU = (float)flipbookTarget.GetWidth() / previewTexture.width;
+		float usedV = (float)flipbookTarget.GetHeight() / previewTexture.height;
+		ImGui::Image((ImTextureID)&previewTexture, {(float)flipbook.frameWidth, (float)flipbook.frameHeight}, {0.0f, 1.0f}, {usedU, 1.0f - usedV});
+
+		ImGui::End();
+	}
+
+	static void Render()
+	{
+		TRACE_SCOPE("Render");
+
+		ClearBackground(WHITE);
+		
+		if (showFlipbook && flipbook.frameCount > 0)
+			RenderFlipbookPreview();
+
+		{
+			TRACE_SCOPE("rlImGuiBegin");
+			rlImGuiBegin();
+		}
+
+		// Menu Bar
+		if (ImGui::BeginMainMenuBar())
+		{
+			if (ImGui::BeginMenu("File"))
+			{
+				if (ImGui::MenuItem("Save", "ctrl+s"))
+					askSave = true;
+
+				if (ImGui::MenuItem("Open", "ctrl+o"))
+					askOpen = true;
+
+				ImGui::EndMenu();
+			}
+			if (ImGui::BeginMenu("Trace"))
+			{
+				if (!Trace::IsRecording())
+				{
+					if (ImGui::MenuItem("Start recording"))
+						Trace::Start();
+				}
+				else
+				{
+					ImGui::TextDisabled("Recording, %zu events", Trace::GetEventCount());
+					// Open in Perfetto or chrome://tracing
+					if (ImGui::MenuItem("Stop and save"))
+						Trace::Stop(fmt::format("trace-{}.json", std::time(nullptr)));
+				}
+				ImGui::EndMenu();
+			}
+			if (ImGui::BeginMenu("View"))
+			{
+				ImGui::MenuItem("Stats", nullptr, &showStats);
+				ImGui::MenuItem("Profiler", nullptr, &showProfiler);
+				ImGui::MenuItem("Timeline", nullptr, &showTimeline);
+				ImGui::MenuItem("Scene", nullptr, &showScene);
+				ImGui::MenuItem("Flipbook", nullptr, &showFlipbook);
+				ImGui::EndMenu();
+			}
+			ImGui::EndMainMenuBar();
+		}
+
+		// Dockspace
+		ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
+
+		// Viewport
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
+		// Hidden behind another tab or collapsed, the texture is neither drawn nor resized
+		viewportVisible = ImGui::Begin("Viewport");
+		if (viewportVisible)
+		{
+			ImVec2 viewportNewSize = ImGui::GetContentRegionAvail();
+			if (viewportNewSize.x != viewportSize.x || viewportNewSize.y != viewportSize.y)
+			{
+				OnViewportResize(viewportNewSize.x, viewportNewSize.y);
+				viewportSize = viewportNewSize;
+			}
+
+			// ImGui only draws at rlImGuiEnd, so the texture is up to date with this frame's size
+			RenderViewport();
+
+			// The texture can be larger than the viewport, only show the used top left corner
+			const Texture2D& viewportTexture = viewportTarget.GetTexture();
+			float usedU = (float)viewportTarget.GetWidth() / viewportTexture.width;
+			float usedV = (float)viewportTarget.GetHeight() / viewportTexture.height;
+			ImGui::Image((ImTextureID)&viewportTexture, viewportSize, {0.0f, 1.0f}, {usedU, 1.0f - usedV});
+		}
+		viewportFocused = viewportVisible && ImGui::IsWindowFocused();
+		viewportPosition = ImGui::GetWindowPos();
+		ImGui::End();
+		ImGui::PopStyleVar();
+
+		if (showStats)
+		{
+			ImGui::SetNextWindowPos({viewportPosition.x + 10.0f, viewportPosition.y + 30.0f});
+			ImGui::SetNextWindowBgAlpha(0.5f);
+			ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+			if (ImGui::Begin("Stats", &showStats, flags))
+			{
+				static const char* THROTTLE_NAMES[] = {"active", "background", "idle", "hidden"};
+				ImGui::Text("FPS: %d (%s, target %d), CPU: %.0f%%", GetFPS(), THROTTLE_NAMES[(int)idleThrottle.GetState()], idleThrottle.GetTargetFPS(), idleThrottle.GetCpuUsage() * 100.0f);
+				ImGui::Text("Viewport: %.0fx%.0f drawn at %dx%d in %.2f ms (texture %dx%d)", viewportSize.x, viewportSize.y, viewportTarget.GetWidth(), viewportTarget.GetHeight(), viewportMilliseconds, viewportTarget.GetCapacityWidth(), viewportTarget.GetCapacityHeight());
+				ImGui::Text("Render texture allocations: %d", RenderTarget::GetAllocationCount());
+				ImGui::Text("Log dropped: %zu console, %zu file", log.GetDroppedCount(), fileLog.GetDroppedCount());
+				if (deterministic && viewportRenderer == ViewportRenderer::Software)
+					ImGui::Text("Particles: rasterized in %.2f ms, %zu tile bins", softwareMilliseconds, softwareRasterizer.GetBinnedCount());
+				else if (deterministic && viewportRenderer == ViewportRenderer::Batched && particleRenderer.IsSupported())
+					ImGui::Text("Particles: %zu draw calls, %zu vertices", particleRenderer.GetDrawCalls(), particleRenderer.GetVertices());
+				else
+					ImGui::Text("Particles: drawn one by one");
+			}
+			ImGui::End();
+		}
+		
+
+		RenderPropertyEditor();
 
 		// Save dialog
 		if (askSave)
@@ -226,16 +1033,15 @@ namespace MainScreen
 
 			ImGui::Begin("Save as...");
 
-			static std::string emitterNameBuf;
 			static std::string filenameBuf;
-			ImGui::InputTextWithHint("Emitter name", "MyEmitter", &emitterNameBuf, ImGuiInputTextFlags_EscapeClearsAll);
+			ImGui::InputTextWithHint("Emitter name", "MyEmitter", &Selected().name, ImGuiInputTextFlags_EscapeClearsAll);
 			
 
 			if (ImGui::Button("..."))
 			{
 				NFD::UniquePath outPath;
-				nfdfilteritem_t filterItem[2] = {{"Save file", "save"}, {"Text file", "txt"}};
-				nfdresult_t result = NFD::SaveDialog(outPath, filterItem, 2, filenameBuf.c_str(), filenameBuf.c_str());
+				nfdfilteritem_t filterItem[4] = {{"Save file", "save"}, {"Text file", "txt"}, {"Binary emitter", "pbin"}, {"Scene", "pscene"}};
+				nfdresult_t result = NFD::SaveDialog(outPath, filterItem, 4, filenameBuf.c_str(), filenameBuf.c_str());
 
 				if (result == NFD_OKAY)
 					filenameBuf = outPath.get();
@@ -250,7 +1056,13 @@ namespace MainScreen
 			{
 				// TODO: Show that the file was saved
 				// TODO: Ask for filename in a better way
-				ParticleSerializer::Serialize(filenameBuf, emitterNameBuf, emitter);
+				// Scenes save every emitter, the other formats only the selected one
+				if (HasExtension(filenameBuf, ".pscene"))
+					ParticleSerializer::SerializeScene(filenameBuf, emitters, (size_t)particleBudget);
+				else if (HasExtension(filenameBuf, ".pbin"))
+					ParticleSerializer::SerializeBinary(filenameBuf, Selected().name, Selected().emitter, &Selected().extras);
+				else
+					ParticleSerializer::Serialize(filenameBuf, Selected().name, Selected().emitter, &Selected().extras);
 			}
 			ImGui::SameLine();
 			if (ImGui::Button("Cancel"))
@@ -268,8 +1080,8 @@ namespace MainScreen
 			if (ImGui::Button("..."))
 			{
 				NFD::UniquePath outPath;
-				nfdfilteritem_t filterItem[2] = {{"Save file", "save"}, {"Text file", "txt"}};
-				nfdresult_t result = NFD::OpenDialog(outPath, filterItem, 2, filenameBuf.c_str());
+				nfdfilteritem_t filterItem[5] = {{"Save file", "save"}, {"Text file", "txt"}, {"Binary emitter", "pbin"}, {"Emitter bank", "pbank"}, {"Scene", "pscene"}};
+				nfdresult_t result = NFD::OpenDialog(outPath, filterItem, 5, filenameBuf.c_str());
 				if (result == NFD_OKAY)
 					filenameBuf = outPath.get();
 				else if (result != NFD_CANCEL)
@@ -279,17 +1091,76 @@ namespace MainScreen
 			bool entered = ImGui::InputTextWithHint("Filename", "in.txt", &filenameBuf, ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_EscapeClearsAll);
 			if (entered || ImGui::Button("Open"))
 			{
-				askOpen = false;
-				ParticleSerializer::Deserialize(filenameBuf, &emitter);
+				if (HasExtension(filenameBuf, ".pbank"))
+				{
+					// Stay open so an emitter can be picked from the bank
+					ParticleSerializer::OpenBank(filenameBuf, &openBank);
+				}
+				else if (HasExtension(filenameBuf, ".pscene"))
+				{
+					askOpen = false;
+					std::vector<ParticleSerializer::SceneEmitter> loaded;
+					size_t budget = ParticlePool::DEFAULT_BUDGET;
+					if (ParticleSerializer::DeserializeScene(filenameBuf, &loaded, &budget))
+						LoadScene(loaded, budget);
+				}
+				else
+				{
+					// Replaces the selected emitter of the scene
+					askOpen = false;
+					ParticleSerializer::SceneEmitter& entry = Selected();
+					bool loaded;
+					if (HasExtension(filenameBuf, ".pbin"))
+						loaded = ParticleSerializer::DeserializeBinary(filenameBuf, &entry.emitter, &entry.name, &entry.extras);
+					else
+						loaded = ParticleSerializer::Deserialize(filenameBuf, &entry.emitter, &entry.name, &entry.extras);
+					if (loaded)
+						OnEmitterLoaded();
+				}
 			}
 			ImGui::SameLine();
 			if (ImGui::Button("Cancel"))
 				askOpen = false;
 
+			if (openBank.IsOpen() && ImGui::BeginListBox("Bank emitters", {-FLT_MIN, 0.0f}))
+			{
+				for (size_t i = 0; i < openBank.GetCount(); i++)
+				{
+					std::string_view name = openBank.GetName(i);
+					ImGui::PushID((int)i);
+					if (ImGui::Selectable(std::string(name).c_str()))
+					{
+						askOpen = false;
+						if (ParticleSerializer::DeserializeFromBank(openBank, name, &Selected().emitter, &Selected().extras))
+						{
+							Selected().name = name;
+							OnEmitterLoaded();
+						}
+					}
+					ImGui::PopID();
+				}
+				ImGui::EndListBox();
+			}
+
 			ImGui::End();
 		}
-		rlImGuiEnd();
+		if (showProfiler)
+			Profiler::DrawWindow(&showProfiler);
+		if (showScene)
+			RenderScene();
+		if (showFlipbook)
+			RenderFlipbook();
+		if (showTimeline)
+			RenderTimeline();
+		else
+			scrubbing = false;
 
+		{
+			TRACE_SCOPE("rlImGuiEnd");
+			rlImGuiEnd();
+		}
+
+		PROFILE_SCOPE(ConsoleLogRender);
 		log.Render(true);
 	}
 
@@ -299,6 +1170,11 @@ namespace MainScreen
 		(void)height;
 	}
 
+	bool PropertiesChanged()
+	{
+		return propertiesChanged;
+	}
+
 	Screen GetScreen()
 	{
 		Screen screen;
@@ -5,4 +5,7 @@
 namespace MainScreen 
 {
 	Screen GetScreen();	
+
+	// True if the emitter was edited or loaded during the last rendered frame
+	bool PropertiesChanged();
 } // MainScreen
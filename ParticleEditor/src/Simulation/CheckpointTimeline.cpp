@@ -0,0 +1,198 @@
+#include "CheckpointTimeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Words are XORed with the previous one and split into byte planes, so
+// columns of similar floats turn into long runs of zeros for the RLE below
+void CheckpointTimeline::Shuffle(const std::vector<uint32_t>& words, std::vector<unsigned char>* planes)
+{
+	size_t count = words.size();
+	planes->resize(count * 4);
+	uint32_t previous = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t delta = words[i] ^ previous;
+		previous = words[i];
+		for (size_t b = 0; b < 4; b++)
+			(*planes)[b * count + i] = (unsigned char)(delta >> (b * 8));
+	}
+}
+
+void CheckpointTimeline::Unshuffle(const std::vector<unsigned char>& planes, std::vector<uint32_t>* words)
+{
+	size_t count = planes.size() / 4;
+	words->resize(count);
+	uint32_t previous = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t delta = 0;
+		for (size_t b = 0; b < 4; b++)
+			delta |= (uint32_t)planes[b * count + i] << (b * 8);
+		previous ^= delta;
+		(*words)[i] = previous;
+	}
+}
+
+// PackBits: control byte n < 128 is followed by n + 1 literal bytes,
+// n >= 128 repeats the next byte n - 125 times
+void CheckpointTimeline::Compress(const std::vector<unsigned char>& input, std::vector<unsigned char>* output)
+{
+	uint32_t size = (uint32_t)input.size();
+	output->resize(sizeof(size));
+	std::memcpy(output->data(), &size, sizeof(size));
+
+	size_t i = 0;
+	while (i < input.size())
+	{
+		size_t run = 1;
+		while (i + run < input.size() && run < 130 && input[i + run] == input[i])
+			run++;
+
+		if (run >= 3)
+		{
+			output->push_back((unsigned char)(run + 125));
+			output->push_back(input[i]);
+			i += run;
+			continue;
+		}
+
+		// Literals until the next run of 3 or the 128 byte limit
+		size_t start = i;
+		while (i < input.size() && i - start < 128)
+		{
+			if (i + 2 < input.size() && input[i] == input[i + 1] && input[i] == input[i + 2])
+				break;
+			i++;
+		}
+		output->push_back((unsigned char)(i - start - 1));
+		output->insert(output->end(), input.begin() + start, input.begin() + i);
+	}
+}
+
+bool CheckpointTimeline::Decompress(const std::vector<unsigned char>& input, std::vector<unsigned char>* output)
+{
+	uint32_t size;
+	if (input.size() < sizeof(size))
+		return false;
+	std::memcpy(&size, input.data(), sizeof(size));
+
+	output->clear();
+	output->reserve(size);
+	size_t i = sizeof(size);
+	while (i < input.size())
+	{
+		unsigned char control = input[i++];
+		if (control < 128)
+		{
+			size_t length = control + 1;
+			if (i + length > input.size())
+				return false;
+			output->insert(output->end(), input.begin() + i, input.begin() + i + length);
+			i += length;
+		}
+		else
+		{
+			if (i >= input.size())
+				return false;
+			output->insert(output->end(), control - 125, input[i++]);
+		}
+	}
+	return output->size() == size;
+}
+
+CheckpointTimeline::CheckpointTimeline()
+{
+}
+
+void CheckpointTimeline::Clear()
+{
+	checkpoints.clear();
+	memory = 0;
+	interval = baseInterval;
+}
+
+void CheckpointTimeline::Record(const ParticleScene& scene)
+{
+	double time = scene.GetTime();
+	// Small tolerance so float steps landing just short of the interval still count
+	if (!checkpoints.empty() && time < checkpoints.back().time + interval - 0.0001)
+		return;
+
+	scene.SaveState(&words);
+	Shuffle(words, &planes);
+
+	Checkpoint checkpoint;
+	checkpoint.time = time;
+	Compress(planes, &checkpoint.data);
+	checkpoint.data.shrink_to_fit();
+
+	memory += checkpoint.data.size();
+	checkpoints.push_back(std::move(checkpoint));
+
+	while (memory > budget && checkpoints.size() > 1)
+		Thin();
+}
+
+bool CheckpointTimeline::Restore(double time, ParticleScene* scene)
+{
+	auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), time,
+		[](double value, const Checkpoint& checkpoint) { return value < checkpoint.time; });
+	if (after == checkpoints.begin())
+		return false;
+
+	const Checkpoint& checkpoint = *(after - 1);
+	if (!Decompress(checkpoint.data, &planes))
+		return false;
+	Unshuffle(planes, &words);
+	return scene->LoadState(words.data(), words.size());
+}
+
+void CheckpointTimeline::Thin()
+{
+	// Keep the first one and every other one after it
+	size_t kept = 0;
+	memory = 0;
+	for (size_t i = 0; i < checkpoints.size(); i += 2)
+	{
+		memory += checkpoints[i].data.size();
+		if (kept != i)
+			checkpoints[kept] = std::move(checkpoints[i]);
+		kept++;
+	}
+	checkpoints.resize(kept);
+	interval *= 2.0f;
+}
+
+size_t CheckpointTimeline::GetCount() const
+{
+	return checkpoints.size();
+}
+
+size_t CheckpointTimeline::GetMemory() const
+{
+	return memory;
+}
+
+float CheckpointTimeline::GetInterval() const
+{
+	return interval;
+}
+
+double CheckpointTimeline::GetLatestTime() const
+{
+	return checkpoints.empty() ? 0.0 : checkpoints.back().time;
+}
+
+void CheckpointTimeline::SetInterval(float _interval)
+{
+	baseInterval = std::max(_interval, 0.01f);
+	Clear();
+}
+
+void CheckpointTimeline::SetBudget(size_t _budget)
+{
+	budget = _budget;
+	while (memory > budget && checkpoints.size() > 1)
+		Thin();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ParticleScene.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Periodic snapshots of a ParticleScene, so seeking to a time only has to
+// simulate from the nearest earlier snapshot. Snapshots are compressed
+// losslessly and the total is kept under a memory budget by dropping every
+// other snapshot (and doubling the interval) whenever it is exceeded.
+class CheckpointTimeline
+{
+public:
+	static constexpr float DEFAULT_INTERVAL = 0.5f;
+	static constexpr size_t DEFAULT_BUDGET = 32 * 1024 * 1024;
+
+	CheckpointTimeline();
+
+	void Clear();
+	// Takes a snapshot if at least an interval passed since the last one
+	void Record(const ParticleScene& scene);
+	// Loads the latest snapshot at or before time, false if there is none
+	bool Restore(double time, ParticleScene* scene);
+
+	size_t GetCount() const;
+	size_t GetMemory() const;
+	float GetInterval() const;
+	double GetLatestTime() const;
+
+	void SetInterval(float interval);
+	void SetBudget(size_t budget);
+
+	// The snapshot codec, public so ParticleTool's selftest can check it round trips exactly.
+	// Shuffle turns words into byte planes of their XOR deltas, Compress run length encodes bytes.
+	static void Shuffle(const std::vector<uint32_t>& words, std::vector<unsigned char>* planes);
+	static void Unshuffle(const std::vector<unsigned char>& planes, std::vector<uint32_t>* words);
+	static void Compress(const std::vector<unsigned char>& input, std::vector<unsigned char>* output);
+	// False if the data is malformed or doesn't decode to the size it was compressed from
+	static bool Decompress(const std::vector<unsigned char>& input, std::vector<unsigned char>* output);
+
+private:
+	struct Checkpoint
+	{
+		double time;
+		std::vector<unsigned char> data;
+	};
+
+	void Thin();
+
+	std::vector<Checkpoint> checkpoints;
+	size_t memory = 0;
+	float baseInterval = DEFAULT_INTERVAL;
+	float interval = DEFAULT_INTERVAL;
+	size_t budget = DEFAULT_BUDGET;
+
+	// Reused between snapshots
+	std::vector<uint32_t> words;
+	std::vector<unsigned char> planes;
+};
@@ -0,0 +1,30 @@
+#include "EmitterSettings.h"
+
+#include <Difu/Particles/ParticleEmitter.h>
+
+#include <algorithm>
+
+EmitterSettings EmitterSettings::FromEmitter(const ParticleEmitter& emitter, Vector2 spawnPosition)
+{
+	EmitterSettings settings;
+	settings.lifetime = emitter.GetParticleLifetime();
+	settings.resolution = emitter.GetParticleResolution();
+	settings.minSizeFactor = emitter.GetParticleMinSizeFactor();
+	settings.maxSizeFactor = emitter.GetParticleMaxSizeFactor();
+	settings.velocity = emitter.GetSpawnVelocity();
+	settings.acceleration = emitter.GetParticleAcceleration();
+	settings.centripetalAcceleration = emitter.GetCentripetalAcceleration();
+	settings.rotation = emitter.GetParticleSpawnRotation();
+	settings.rotationVelocity = emitter.GetParticleSpawnRotationVelocity();
+	settings.rotationAcceleration = emitter.GetParticleRotationAcceleration();
+	settings.startColor = emitter.GetStartColor();
+	settings.endColor = emitter.GetEndColor();
+	// 0 or less turns spawning off
+	settings.spawnInterval = emitter.GetSpawnInterval();
+	if (settings.spawnInterval > 0.0f)
+		settings.spawnInterval = std::max(settings.spawnInterval, MIN_SPAWN_INTERVAL);
+	settings.randomness = emitter.GetRandomness();
+	settings.spread = emitter.GetSpread();
+	settings.spawnPosition = spawnPosition;
+	return settings;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <raylib.h>
+
+class ParticleEmitter;
+
+// The ParticleEmitter properties the editor simulation reads, copied once per step
+struct EmitterSettings
+{
+	// Positive intervals are raised to this, shorter ones would spawn thousands of particles per step
+	// and below a float ulp of the spawn timer they never use it up
+	static constexpr float MIN_SPAWN_INTERVAL = 1e-5f;
+
+	float lifetime = 1.0f;
+	Vector2 resolution = {1.0f, 1.0f};
+	float minSizeFactor = 1.0f;
+	float maxSizeFactor = 1.0f;
+	Vector2 velocity = {0.0f, 0.0f};
+	Vector2 acceleration = {0.0f, 0.0f};
+	float centripetalAcceleration = 0.0f;
+	// Degrees, like raylib's DrawRectanglePro
+	float rotation = 0.0f;
+	float rotationVelocity = 0.0f;
+	float rotationAcceleration = 0.0f;
+	Color startColor = BLACK;
+	Color endColor = WHITE;
+	float spawnInterval = 0.1f;
+	float randomness = 0.0f;
+	// Radians, the cone the spawn velocity is rotated within
+	float spread = 0.0f;
+	Vector2 spawnPosition = {0.0f, 0.0f};
+
+	static EmitterSettings FromEmitter(const ParticleEmitter& emitter, Vector2 spawnPosition);
+};
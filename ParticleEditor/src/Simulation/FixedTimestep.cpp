@@ -0,0 +1,58 @@
+#include "FixedTimestep.h"
+
+#include <algorithm>
+
+FixedTimestep::FixedTimestep()
+{
+}
+
+int FixedTimestep::Advance(float dt)
+{
+	accumulator += std::max(dt, 0.0f);
+
+	int steps = (int)(accumulator / step);
+	accumulator -= steps * step;
+	if (steps > maxSubsteps)
+	{
+		droppedTime += (double)(steps - maxSubsteps) * step;
+		steps = maxSubsteps;
+	}
+
+	return steps;
+}
+
+void FixedTimestep::Reset()
+{
+	accumulator = 0.0f;
+	droppedTime = 0.0;
+}
+
+float FixedTimestep::GetAlpha() const
+{
+	return std::min(accumulator / step, 1.0f);
+}
+
+float FixedTimestep::GetStep() const
+{
+	return step;
+}
+
+int FixedTimestep::GetMaxSubsteps() const
+{
+	return maxSubsteps;
+}
+
+double FixedTimestep::GetDroppedTime() const
+{
+	return droppedTime;
+}
+
+void FixedTimestep::SetStep(float _step)
+{
+	step = std::max(_step, 0.0001f);
+}
+
+void FixedTimestep::SetMaxSubsteps(int _maxSubsteps)
+{
+	maxSubsteps = std::max(_maxSubsteps, 1);
+}
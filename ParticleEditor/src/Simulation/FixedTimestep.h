@@ -0,0 +1,33 @@
+#pragma once
+
+// Turns variable frame times into a whole number of fixed steps.
+// Time left over stays in the accumulator and GetAlpha() tells the renderer
+// how far it is into the next step. A hitch runs at most maxSubsteps steps and
+// the rest of its time is dropped instead of piling up.
+class FixedTimestep
+{
+public:
+	static constexpr float DEFAULT_STEP = 1.0f / 60.0f;
+	static constexpr int DEFAULT_MAX_SUBSTEPS = 4;
+
+	FixedTimestep();
+
+	// Returns how many steps to run this frame
+	int Advance(float dt);
+	void Reset();
+
+	float GetAlpha() const;
+	float GetStep() const;
+	int GetMaxSubsteps() const;
+	// Seconds dropped because a frame needed more than maxSubsteps steps
+	double GetDroppedTime() const;
+
+	void SetStep(float step);
+	void SetMaxSubsteps(int maxSubsteps);
+
+private:
+	float step = DEFAULT_STEP;
+	int maxSubsteps = DEFAULT_MAX_SUBSTEPS;
+	float accumulator = 0.0f;
+	double droppedTime = 0.0;
+};
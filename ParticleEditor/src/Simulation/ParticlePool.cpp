@@ -0,0 +1,110 @@
+#include "ParticlePool.h"
+
+#include <algorithm>
+
+ParticlePool::ParticlePool(size_t budget, ParticleLayout _layout)
+	: layout(_layout)
+{
+	SetBudget(budget);
+}
+
+bool ParticlePool::SetBudget(size_t budget)
+{
+	return Reallocate(std::max<size_t>((budget + BLOCK_SIZE - 1) / BLOCK_SIZE, 1), layout);
+}
+
+bool ParticlePool::SetLayout(ParticleLayout _layout)
+{
+	return Reallocate(blockCount, _layout);
+}
+
+bool ParticlePool::Reallocate(size_t _blockCount, ParticleLayout _layout)
+{
+	if (freeBlocks.size() != blockCount)
+		return false;
+
+	blockCount = _blockCount;
+	layout = _layout;
+	if (layout == ParticleLayout::ArrayOfStructs)
+	{
+		particles.assign(blockCount * BLOCK_SIZE, SimParticle{});
+		soaBlocks.clear();
+	}
+	else
+	{
+		// Zeroed, so the lanes a kernel runs past the last particle hold finite values
+		soaBlocks.assign(blockCount, SoaParticleBlock{});
+		particles.clear();
+	}
+	particles.shrink_to_fit();
+	soaBlocks.shrink_to_fit();
+
+	freeBlocks.resize(blockCount);
+	freeBlocks.shrink_to_fit();
+	// Block 0 on top so a fresh pool hands blocks out in address order
+	for (size_t i = 0; i < blockCount; i++)
+		freeBlocks[i] = (uint32_t)(blockCount - 1 - i);
+	return true;
+}
+
+uint32_t ParticlePool::Allocate()
+{
+	if (freeBlocks.empty())
+		return NO_BLOCK;
+
+	uint32_t block = freeBlocks.back();
+	freeBlocks.pop_back();
+	return block;
+}
+
+void ParticlePool::Free(uint32_t block)
+{
+	// Never grows, capacity is the block count from SetBudget
+	if (block < blockCount && freeBlocks.size() < blockCount)
+		freeBlocks.push_back(block);
+}
+
+SimParticle* ParticlePool::GetBlock(uint32_t block)
+{
+	return particles.data() + (size_t)block * BLOCK_SIZE;
+}
+
+const SimParticle* ParticlePool::GetBlock(uint32_t block) const
+{
+	return particles.data() + (size_t)block * BLOCK_SIZE;
+}
+
+SoaParticleBlock* ParticlePool::GetSoaBlock(uint32_t block)
+{
+	return soaBlocks.data() + block;
+}
+
+const SoaParticleBlock* ParticlePool::GetSoaBlock(uint32_t block) const
+{
+	return soaBlocks.data() + block;
+}
+
+ParticleLayout ParticlePool::GetLayout() const
+{
+	return layout;
+}
+
+size_t ParticlePool::GetBlockCount() const
+{
+	return blockCount;
+}
+
+size_t ParticlePool::GetFreeBlockCount() const
+{
+	return freeBlocks.size();
+}
+
+size_t ParticlePool::GetCapacity() const
+{
+	return blockCount * BLOCK_SIZE;
+}
+
+size_t ParticlePool::GetMemory() const
+{
+	return particles.capacity() * sizeof(SimParticle) + soaBlocks.capacity() * sizeof(SoaParticleBlock) + freeBlocks.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SimParticle
+{
+	Vector2 position;
+	Vector2 previousPosition;
+	Vector2 velocity;
+	float rotation;
+	float previousRotation;
+	float rotationVelocity;
+	float age;
+	float lifetime;
+	float sizeFactor;
+};
+
+enum class ParticleLayout
+{
+	ArrayOfStructs,
+	StructOfArrays
+};
+
+// The same fields as SimParticle, one aligned array each, plus the color
+// the update kernel lerps from the start to the end color
+struct alignas(32) SoaParticleBlock
+{
+	static constexpr size_t SIZE = 256;
+
+	float positionX[SIZE];
+	float positionY[SIZE];
+	float previousX[SIZE];
+	float previousY[SIZE];
+	float velocityX[SIZE];
+	float velocityY[SIZE];
+	float rotation[SIZE];
+	float previousRotation[SIZE];
+	float rotationVelocity[SIZE];
+	float age[SIZE];
+	float lifetime[SIZE];
+	float sizeFactor[SIZE];
+	float colorR[SIZE];
+	float colorG[SIZE];
+	float colorB[SIZE];
+	float colorA[SIZE];
+};
+
+// Particle storage shared by every ParticleSystem of a scene. All of it is
+// allocated up front and handed out in fixed size blocks through a free list,
+// so spawning and retiring particles never touches the heap and the whole
+// scene never holds more than the budget. A block is either BLOCK_SIZE
+// SimParticles or one SoaParticleBlock, depending on the pool's layout.
+class ParticlePool
+{
+public:
+	static constexpr size_t BLOCK_SIZE = SoaParticleBlock::SIZE;
+	static constexpr size_t DEFAULT_BUDGET = 100000;
+	static constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+	// The budget is in particles, rounded up to whole blocks
+	explicit ParticlePool(size_t budget = DEFAULT_BUDGET, ParticleLayout layout = ParticleLayout::ArrayOfStructs);
+
+	// Both reallocate, false (and unchanged) while any block is still in use
+	bool SetBudget(size_t budget);
+	bool SetLayout(ParticleLayout layout);
+
+	// Returns NO_BLOCK once the budget is used up
+	uint32_t Allocate();
+	void Free(uint32_t block);
+
+	// Only valid for the pool's layout
+	SimParticle* GetBlock(uint32_t block);
+	const SimParticle* GetBlock(uint32_t block) const;
+	SoaParticleBlock* GetSoaBlock(uint32_t block);
+	const SoaParticleBlock* GetSoaBlock(uint32_t block) const;
+
+	ParticleLayout GetLayout() const;
+	size_t GetBlockCount() const;
+	size_t GetFreeBlockCount() const;
+	size_t GetCapacity() const;
+	size_t GetMemory() const;
+
+private:
+	bool Reallocate(size_t blockCount, ParticleLayout layout);
+
+	ParticleLayout layout;
+	size_t blockCount = 0;
+	// Only the one for the current layout is allocated
+	std::vector<SimParticle> particles;
+	std::vector<SoaParticleBlock> soaBlocks;
+	// Used as a stack, the most recently freed (and likely still cached) block is reused first
+	std::vector<uint32_t> freeBlocks;
+};
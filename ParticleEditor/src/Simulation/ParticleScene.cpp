@@ -0,0 +1,179 @@
+#include "ParticleScene.h"
+
+#include "Utils/JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+ParticleScene::ParticleScene(size_t budget)
+	: pool(budget)
+{
+}
+
+size_t ParticleScene::Add()
+{
+	systems.emplace_back(&pool);
+	return systems.size() - 1;
+}
+
+void ParticleScene::Remove(size_t index)
+{
+	if (index < systems.size())
+		systems.erase(systems.begin() + index);
+}
+
+void ParticleScene::Reset(uint64_t seed)
+{
+	time = 0.0;
+	// The first system uses the seed as is, so a one emitter scene matches a lone ParticleSystem
+	for (size_t i = 0; i < systems.size(); i++)
+		systems[i].Reset(seed + i * 0x9E3779B97F4A7C15ull);
+}
+
+void ParticleScene::Step(const EmitterSettings* settings, float dt, JobSystem* jobs)
+{
+	time += dt;
+	if (!jobs || jobs->GetWorkerCount() == 0)
+	{
+		for (size_t i = 0; i < systems.size(); i++)
+			systems[i].Step(settings[i], dt);
+		return;
+	}
+
+	// Large systems are split into several chunks so they don't hold up the others
+	chunks.clear();
+	for (size_t i = 0; i < systems.size(); i++)
+	{
+		size_t blockCount = systems[i].GetBlockCount();
+		for (size_t first = 0; first < blockCount; first += CHUNK_BLOCKS)
+			chunks.push_back({i, first, std::min(first + CHUNK_BLOCKS, blockCount)});
+	}
+
+	jobs->ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			systems[chunks[i].system].IntegrateBlocks(settings[chunks[i].system], dt, chunks[i].first, chunks[i].end);
+	});
+	jobs->ParallelFor(systems.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			systems[i].Compact();
+	});
+
+	// Block allocation and spawning stay in system order, so the result matches stepping serially
+	for (size_t i = 0; i < systems.size(); i++)
+		systems[i].FinishStep(settings[i], dt);
+}
+
+bool ParticleScene::SetBudget(size_t budget)
+{
+	if (budget == 0)
+		return false;
+
+	for (ParticleSystem& system : systems)
+		system.Reset(0);
+	time = 0.0;
+	return pool.SetBudget(budget);
+}
+
+bool ParticleScene::SetLayout(ParticleLayout layout)
+{
+	for (ParticleSystem& system : systems)
+		system.Reset(0);
+	time = 0.0;
+	return pool.SetLayout(layout);
+}
+
+size_t ParticleScene::GetCount() const
+{
+	return systems.size();
+}
+
+ParticleSystem& ParticleScene::GetSystem(size_t index)
+{
+	return systems[index];
+}
+
+const ParticleSystem& ParticleScene::GetSystem(size_t index) const
+{
+	return systems[index];
+}
+
+const ParticlePool& ParticleScene::GetPool() const
+{
+	return pool;
+}
+
+size_t ParticleScene::GetParticleCount() const
+{
+	size_t count = 0;
+	for (const ParticleSystem& system : systems)
+		count += system.GetCount();
+	return count;
+}
+
+double ParticleScene::GetTime() const
+{
+	return time;
+}
+
+uint64_t ParticleScene::GetStateHash() const
+{
+	std::vector<uint32_t> state;
+	SaveState(&state);
+	return ParticleSystem::HashState(state);
+}
+
+// Header words: system count, time (2)
+static constexpr size_t SCENE_HEADER_WORDS = 3;
+
+void ParticleScene::SaveState(std::vector<uint32_t>* state) const
+{
+	uint64_t timeBits;
+	std::memcpy(&timeBits, &time, sizeof(timeBits));
+
+	state->resize(SCENE_HEADER_WORDS);
+	(*state)[0] = (uint32_t)systems.size();
+	(*state)[1] = (uint32_t)timeBits;
+	(*state)[2] = (uint32_t)(timeBits >> 32);
+
+	for (const ParticleSystem& system : systems)
+	{
+		system.SaveState(&systemState);
+		state->push_back((uint32_t)systemState.size());
+		state->insert(state->end(), systemState.begin(), systemState.end());
+	}
+}
+
+bool ParticleScene::LoadState(const uint32_t* state, size_t size)
+{
+	if (size < SCENE_HEADER_WORDS || state[0] != systems.size())
+		return false;
+
+	// Check the layout before touching any system
+	size_t offset = SCENE_HEADER_WORDS;
+	for (size_t i = 0; i < systems.size(); i++)
+	{
+		if (offset >= size || state[offset] > size - offset - 1)
+			return false;
+		offset += 1 + state[offset];
+	}
+	if (offset != size)
+		return false;
+
+	// Free every block first, so systems loading later can use blocks earlier ones give up
+	for (ParticleSystem& system : systems)
+		system.Reset(0);
+
+	offset = SCENE_HEADER_WORDS;
+	for (ParticleSystem& system : systems)
+	{
+		if (!system.LoadState(state + offset + 1, state[offset]))
+			return false;
+		offset += 1 + state[offset];
+	}
+
+	uint64_t timeBits = state[1] | ((uint64_t)state[2] << 32);
+	std::memcpy(&time, &timeBits, sizeof(time));
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ParticlePool.h"
+#include "ParticleSystem.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Several ParticleSystems drawing their particles from one shared ParticlePool.
+// Systems are stepped in order, so which one gets a block when the budget runs
+// out is decided the same way every run and the scene stays deterministic.
+class ParticleScene
+{
+public:
+	explicit ParticleScene(size_t budget = ParticlePool::DEFAULT_BUDGET);
+
+	// The pool is referenced by every system, so the scene stays where it is
+	ParticleScene(const ParticleScene&) = delete;
+	ParticleScene& operator=(const ParticleScene&) = delete;
+
+	// Returns the index of the new system
+	size_t Add();
+	void Remove(size_t index);
+
+	// Each system gets its own sequence derived from seed and its index
+	void Reset(uint64_t seed);
+	// settings holds one entry per system. With jobs the systems are integrated
+	// on its workers, the resulting state is the same either way.
+	void Step(const EmitterSettings* settings, float dt, JobSystem* jobs = nullptr);
+
+	// Both drop every particle and reallocate the pool, SetBudget fails for 0
+	bool SetBudget(size_t budget);
+	bool SetLayout(ParticleLayout layout);
+
+	size_t GetCount() const;
+	ParticleSystem& GetSystem(size_t index);
+	const ParticleSystem& GetSystem(size_t index) const;
+	const ParticlePool& GetPool() const;
+	size_t GetParticleCount() const;
+	double GetTime() const;
+	uint64_t GetStateHash() const;
+
+	// The system count, then each system's state prefixed by its size
+	void SaveState(std::vector<uint32_t>* state) const;
+	bool LoadState(const uint32_t* state, size_t size);
+
+private:
+	// Declared first, systems return their blocks to it when destroyed
+	ParticlePool pool;
+	std::vector<ParticleSystem> systems;
+	double time = 0.0;
+
+	// Reused by SaveState
+	mutable std::vector<uint32_t> systemState;
+
+	// A range of one system's blocks integrated by one job
+	struct Chunk
+	{
+		size_t system;
+		size_t first;
+		size_t end;
+	};
+	static constexpr size_t CHUNK_BLOCKS = 4;
+	// Reused by Step
+	std::vector<Chunk> chunks;
+};
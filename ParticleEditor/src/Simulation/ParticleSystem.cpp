@@ -0,0 +1,513 @@
+#include "ParticleSystem.h"
+#include "SoaKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+ParticleSystem::ParticleSystem(ParticlePool* _pool)
+	: pool(_pool)
+{
+	if (!pool)
+	{
+		ownPool = std::make_unique<ParticlePool>();
+		pool = ownPool.get();
+	}
+	blocks.reserve(pool->GetBlockCount());
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	ReleaseBlocks(0);
+}
+
+ParticleSystem::ParticleSystem(ParticleSystem&& other) noexcept
+	: ownPool(std::move(other.ownPool)), pool(other.pool), blocks(std::move(other.blocks)),
+	count(other.count), spawnTimer(other.spawnTimer), time(other.time), random(other.random), colorsCurrent(other.colorsCurrent)
+{
+	other.blocks.clear();
+	other.count = 0;
+}
+
+ParticleSystem& ParticleSystem::operator=(ParticleSystem&& other) noexcept
+{
+	if (this != &other)
+	{
+		ReleaseBlocks(0);
+		ownPool = std::move(other.ownPool);
+		pool = other.pool;
+		blocks = std::move(other.blocks);
+		count = other.count;
+		spawnTimer = other.spawnTimer;
+		time = other.time;
+		random = other.random;
+		colorsCurrent = other.colorsCurrent;
+		other.blocks.clear();
+		other.count = 0;
+	}
+	return *this;
+}
+
+void ParticleSystem::Reset(uint64_t seed)
+{
+	ReleaseBlocks(0);
+	// The pool's budget may have changed since the last reset
+	blocks.reserve(pool->GetBlockCount());
+	count = 0;
+	spawnTimer = 0.0f;
+	time = 0.0;
+	random.Seed(seed);
+}
+
+SimParticle ParticleSystem::Read(size_t index) const
+{
+	size_t slot = index % ParticlePool::BLOCK_SIZE;
+	if (pool->GetLayout() == ParticleLayout::ArrayOfStructs)
+		return pool->GetBlock(blocks[index / ParticlePool::BLOCK_SIZE])[slot];
+
+	const SoaParticleBlock* block = pool->GetSoaBlock(blocks[index / ParticlePool::BLOCK_SIZE]);
+	SimParticle particle;
+	particle.position = {block->positionX[slot], block->positionY[slot]};
+	particle.previousPosition = {block->previousX[slot], block->previousY[slot]};
+	particle.velocity = {block->velocityX[slot], block->velocityY[slot]};
+	particle.rotation = block->rotation[slot];
+	particle.previousRotation = block->previousRotation[slot];
+	particle.rotationVelocity = block->rotationVelocity[slot];
+	particle.age = block->age[slot];
+	particle.lifetime = block->lifetime[slot];
+	particle.sizeFactor = block->sizeFactor[slot];
+	return particle;
+}
+
+void ParticleSystem::Write(size_t index, const SimParticle& particle)
+{
+	size_t slot = index % ParticlePool::BLOCK_SIZE;
+	if (pool->GetLayout() == ParticleLayout::ArrayOfStructs)
+	{
+		pool->GetBlock(blocks[index / ParticlePool::BLOCK_SIZE])[slot] = particle;
+		return;
+	}
+
+	SoaParticleBlock* block = pool->GetSoaBlock(blocks[index / ParticlePool::BLOCK_SIZE]);
+	block->positionX[slot] = particle.position.x;
+	block->positionY[slot] = particle.position.y;
+	block->previousX[slot] = particle.previousPosition.x;
+	block->previousY[slot] = particle.previousPosition.y;
+	block->velocityX[slot] = particle.velocity.x;
+	block->velocityY[slot] = particle.velocity.y;
+	block->rotation[slot] = particle.rotation;
+	block->previousRotation[slot] = particle.previousRotation;
+	block->rotationVelocity[slot] = particle.rotationVelocity;
+	block->age[slot] = particle.age;
+	block->lifetime[slot] = particle.lifetime;
+	block->sizeFactor[slot] = particle.sizeFactor;
+}
+
+void ParticleSystem::Move(size_t from, size_t to)
+{
+	if (pool->GetLayout() == ParticleLayout::ArrayOfStructs)
+	{
+		Write(to, Read(from));
+		return;
+	}
+
+	// Every array, the color included
+	using Array = float (SoaParticleBlock::*)[SoaParticleBlock::SIZE];
+	static constexpr Array ARRAYS[] = {
+		&SoaParticleBlock::positionX, &SoaParticleBlock::positionY, &SoaParticleBlock::previousX, &SoaParticleBlock::previousY,
+		&SoaParticleBlock::velocityX, &SoaParticleBlock::velocityY, &SoaParticleBlock::rotation, &SoaParticleBlock::previousRotation,
+		&SoaParticleBlock::rotationVelocity, &SoaParticleBlock::age, &SoaParticleBlock::lifetime, &SoaParticleBlock::sizeFactor,
+		&SoaParticleBlock::colorR, &SoaParticleBlock::colorG, &SoaParticleBlock::colorB, &SoaParticleBlock::colorA
+	};
+
+	const SoaParticleBlock* source = pool->GetSoaBlock(blocks[from / ParticlePool::BLOCK_SIZE]);
+	SoaParticleBlock* destination = pool->GetSoaBlock(blocks[to / ParticlePool::BLOCK_SIZE]);
+	size_t sourceSlot = from % ParticlePool::BLOCK_SIZE;
+	size_t destinationSlot = to % ParticlePool::BLOCK_SIZE;
+	for (Array array : ARRAYS)
+		(destination->*array)[destinationSlot] = (source->*array)[sourceSlot];
+}
+
+Color ParticleSystem::GetColor(const EmitterSettings& settings, float age, float lifetime)
+{
+	float t = lifetime > 0.0f ? std::min(age / lifetime, 1.0f) : 1.0f;
+	return {
+		(unsigned char)(settings.startColor.r + (settings.endColor.r - settings.startColor.r) * t),
+		(unsigned char)(settings.startColor.g + (settings.endColor.g - settings.startColor.g) * t),
+		(unsigned char)(settings.startColor.b + (settings.endColor.b - settings.startColor.b) * t),
+		(unsigned char)(settings.startColor.a + (settings.endColor.a - settings.startColor.a) * t)
+	};
+}
+
+void ParticleSystem::ReleaseBlocks(size_t keep)
+{
+	while (blocks.size() > keep)
+	{
+		pool->Free(blocks.back());
+		blocks.pop_back();
+	}
+}
+
+void ParticleSystem::Step(const EmitterSettings& settings, float dt)
+{
+	IntegrateBlocks(settings, dt, 0, blocks.size());
+	Compact();
+	FinishStep(settings, dt);
+}
+
+static void IntegrateBlock(SimParticle* particles, size_t count, const EmitterSettings& settings, float dt)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		SimParticle& particle = particles[i];
+		particle.previousPosition = particle.position;
+		particle.previousRotation = particle.rotation;
+
+		Vector2 acceleration = settings.acceleration;
+		if (settings.centripetalAcceleration != 0.0f)
+		{
+			// Pulls towards the spawn position
+			float dx = settings.spawnPosition.x - particle.position.x;
+			float dy = settings.spawnPosition.y - particle.position.y;
+			float length = std::sqrt(dx * dx + dy * dy);
+			if (length > 0.0001f)
+			{
+				acceleration.x += dx / length * settings.centripetalAcceleration;
+				acceleration.y += dy / length * settings.centripetalAcceleration;
+			}
+		}
+
+		particle.velocity.x += acceleration.x * dt;
+		particle.velocity.y += acceleration.y * dt;
+		particle.position.x += particle.velocity.x * dt;
+		particle.position.y += particle.velocity.y * dt;
+		particle.rotationVelocity += settings.rotationAcceleration * dt;
+		particle.rotation += particle.rotationVelocity * dt;
+		particle.age += dt;
+	}
+}
+
+void ParticleSystem::IntegrateBlocks(const EmitterSettings& settings, float dt, size_t first, size_t end)
+{
+	end = std::min(end, blocks.size());
+	for (size_t i = first; i < end; i++)
+	{
+		size_t blockCount = std::min(count - i * ParticlePool::BLOCK_SIZE, ParticlePool::BLOCK_SIZE);
+		if (pool->GetLayout() == ParticleLayout::StructOfArrays)
+			SoaKernels::Integrate(pool->GetSoaBlock(blocks[i]), blockCount, settings, dt);
+		else
+			IntegrateBlock(pool->GetBlock(blocks[i]), blockCount, settings, dt);
+	}
+}
+
+void ParticleSystem::Compact()
+{
+	// Swap with the last one, order doesn't matter for drawing or determinism.
+	// Ages are read from the block directly, only expired particles go through Move.
+	bool soa = pool->GetLayout() == ParticleLayout::StructOfArrays;
+	for (size_t b = 0; b * ParticlePool::BLOCK_SIZE < count; b++)
+	{
+		size_t first = b * ParticlePool::BLOCK_SIZE;
+		if (soa)
+		{
+			const SoaParticleBlock* block = pool->GetSoaBlock(blocks[b]);
+			for (size_t slot = 0; slot < ParticlePool::BLOCK_SIZE && first + slot < count;)
+			{
+				if (block->age[slot] >= block->lifetime[slot])
+					Move(--count, first + slot);
+				else
+					slot++;
+			}
+		}
+		else
+		{
+			const SimParticle* block = pool->GetBlock(blocks[b]);
+			for (size_t slot = 0; slot < ParticlePool::BLOCK_SIZE && first + slot < count;)
+			{
+				if (block[slot].age >= block[slot].lifetime)
+					Move(--count, first + slot);
+				else
+					slot++;
+			}
+		}
+	}
+}
+
+void ParticleSystem::FinishStep(const EmitterSettings& settings, float dt)
+{
+	time += dt;
+	ReleaseBlocks((count + ParticlePool::BLOCK_SIZE - 1) / ParticlePool::BLOCK_SIZE);
+	Spawn(settings, dt);
+	colorsCurrent = true;
+}
+
+void ParticleSystem::Spawn(const EmitterSettings& settings, float dt)
+{
+	if (settings.spawnInterval <= 0.0f)
+		return;
+
+	spawnTimer += dt;
+	while (spawnTimer >= settings.spawnInterval)
+	{
+		spawnTimer -= settings.spawnInterval;
+		if (count == blocks.size() * ParticlePool::BLOCK_SIZE)
+		{
+			// The whole scene shares the budget, another system may have used it up
+			uint32_t block = pool->Allocate();
+			if (block == ParticlePool::NO_BLOCK)
+			{
+				// Nothing else fits this step, the rest of the spawns are dropped
+				spawnTimer = std::fmod(spawnTimer, settings.spawnInterval);
+				break;
+			}
+			blocks.push_back(block);
+		}
+
+		float angle = random.Range(-settings.spread * 0.5f, settings.spread * 0.5f);
+		float speed = 1.0f + settings.randomness * random.Range(-1.0f, 1.0f);
+		float cosine = std::cos(angle);
+		float sine = std::sin(angle);
+
+		SimParticle particle;
+		particle.velocity.x = (settings.velocity.x * cosine - settings.velocity.y * sine) * speed;
+		particle.velocity.y = (settings.velocity.x * sine + settings.velocity.y * cosine) * speed;
+		particle.sizeFactor = random.Range(settings.minSizeFactor, settings.maxSizeFactor);
+		particle.lifetime = settings.lifetime;
+		particle.rotation = settings.rotation;
+		particle.rotationVelocity = settings.rotationVelocity;
+
+		// Spawned partway through the step, so it has already lived for what is left of it
+		particle.age = spawnTimer;
+		particle.previousPosition = settings.spawnPosition;
+		particle.previousRotation = settings.rotation;
+		particle.position.x = settings.spawnPosition.x + particle.velocity.x * spawnTimer;
+		particle.position.y = settings.spawnPosition.y + particle.velocity.y * spawnTimer;
+		Write(count, particle);
+
+		// The kernel only colors particles it integrated
+		if (pool->GetLayout() == ParticleLayout::StructOfArrays)
+		{
+			SoaParticleBlock* block = pool->GetSoaBlock(blocks.back());
+			size_t slot = count % ParticlePool::BLOCK_SIZE;
+			Color color = settings.startColor;
+			Color end = settings.endColor;
+			float t = particle.lifetime > 0.0f ? std::min(particle.age / particle.lifetime, 1.0f) : 1.0f;
+			block->colorR[slot] = color.r + (end.r - color.r) * t;
+			block->colorG[slot] = color.g + (end.g - color.g) * t;
+			block->colorB[slot] = color.b + (end.b - color.b) * t;
+			block->colorA[slot] = color.a + (end.a - color.a) * t;
+		}
+		count++;
+	}
+}
+
+void ParticleSystem::Render(const EmitterSettings& settings, float alpha) const
+{
+	ParticleInstance instances[ParticlePool::BLOCK_SIZE];
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		size_t blockCount = GetInstances(b, settings, alpha, instances);
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			const ParticleInstance& instance = instances[i];
+			DrawRectanglePro({instance.x, instance.y, instance.width, instance.height}, {instance.width / 2.0f, instance.height / 2.0f}, instance.rotation, instance.color);
+		}
+	}
+}
+
+size_t ParticleSystem::GetInstances(size_t index, const EmitterSettings& settings, float alpha, ParticleInstance* instances) const
+{
+	size_t blockCount = std::min(count - index * ParticlePool::BLOCK_SIZE, ParticlePool::BLOCK_SIZE);
+	if (pool->GetLayout() == ParticleLayout::ArrayOfStructs)
+	{
+		const SimParticle* block = pool->GetBlock(blocks[index]);
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			const SimParticle& particle = block[i];
+			ParticleInstance& instance = instances[i];
+			instance.x = particle.previousPosition.x + (particle.position.x - particle.previousPosition.x) * alpha;
+			instance.y = particle.previousPosition.y + (particle.position.y - particle.previousPosition.y) * alpha;
+			instance.width = settings.resolution.x * particle.sizeFactor;
+			instance.height = settings.resolution.y * particle.sizeFactor;
+			instance.rotation = particle.previousRotation + (particle.rotation - particle.previousRotation) * alpha;
+			instance.color = GetColor(settings, particle.age, particle.lifetime);
+		}
+		return blockCount;
+	}
+
+	const SoaParticleBlock* block = pool->GetSoaBlock(blocks[index]);
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		ParticleInstance& instance = instances[i];
+		instance.x = block->previousX[i] + (block->positionX[i] - block->previousX[i]) * alpha;
+		instance.y = block->previousY[i] + (block->positionY[i] - block->previousY[i]) * alpha;
+		instance.width = settings.resolution.x * block->sizeFactor[i];
+		instance.height = settings.resolution.y * block->sizeFactor[i];
+		instance.rotation = block->previousRotation[i] + (block->rotation[i] - block->previousRotation[i]) * alpha;
+
+		// Restored states have no colors until the next step
+		if (colorsCurrent)
+			instance.color = {(unsigned char)block->colorR[i], (unsigned char)block->colorG[i], (unsigned char)block->colorB[i], (unsigned char)block->colorA[i]};
+		else
+			instance.color = GetColor(settings, block->age[i], block->lifetime[i]);
+	}
+	return blockCount;
+}
+
+size_t ParticleSystem::GetCount() const
+{
+	return count;
+}
+
+size_t ParticleSystem::GetCapacity() const
+{
+	return pool->GetCapacity();
+}
+
+double ParticleSystem::GetTime() const
+{
+	return time;
+}
+
+size_t ParticleSystem::GetBlockCount() const
+{
+	return blocks.size();
+}
+
+const SimParticle* ParticleSystem::GetBlock(size_t index, size_t* blockCount) const
+{
+	*blockCount = std::min(count - index * ParticlePool::BLOCK_SIZE, ParticlePool::BLOCK_SIZE);
+	return pool->GetBlock(blocks[index]);
+}
+
+const SoaParticleBlock* ParticleSystem::GetSoaBlock(size_t index, size_t* blockCount) const
+{
+	*blockCount = std::min(count - index * ParticlePool::BLOCK_SIZE, ParticlePool::BLOCK_SIZE);
+	return pool->GetSoaBlock(blocks[index]);
+}
+
+ParticleLayout ParticleSystem::GetLayout() const
+{
+	return pool->GetLayout();
+}
+
+// Header words: random state (2), time (2), spawn timer, count
+static constexpr size_t STATE_HEADER_WORDS = 6;
+
+// Previous position and rotation only matter for interpolated rendering and are left out
+static constexpr size_t STATE_PARTICLE_WORDS = 9;
+
+template<typename T>
+static uint32_t ToWord(T value)
+{
+	static_assert(sizeof(T) == sizeof(uint32_t));
+	uint32_t word;
+	std::memcpy(&word, &value, sizeof(word));
+	return word;
+}
+
+template<typename T>
+static T FromWord(uint32_t word)
+{
+	static_assert(sizeof(T) == sizeof(uint32_t));
+	T value;
+	std::memcpy(&value, &word, sizeof(value));
+	return value;
+}
+
+uint64_t ParticleSystem::GetStateHash() const
+{
+	std::vector<uint32_t> state;
+	SaveState(&state);
+	return HashState(state);
+}
+
+uint64_t ParticleSystem::HashState(const std::vector<uint32_t>& state)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t word : state)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			hash ^= (word >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+void ParticleSystem::SaveState(std::vector<uint32_t>* state) const
+{
+	uint64_t randomState = random.GetState();
+	uint64_t timeBits;
+	std::memcpy(&timeBits, &time, sizeof(timeBits));
+
+	state->resize(STATE_HEADER_WORDS + count * STATE_PARTICLE_WORDS);
+	uint32_t* words = state->data();
+	words[0] = (uint32_t)randomState;
+	words[1] = (uint32_t)(randomState >> 32);
+	words[2] = (uint32_t)timeBits;
+	words[3] = (uint32_t)(timeBits >> 32);
+	words[4] = ToWord(spawnTimer);
+	words[5] = (uint32_t)count;
+
+	// One column per field, neighbouring particles tend to have similar values
+	uint32_t* column = words + STATE_HEADER_WORDS;
+	for (size_t i = 0; i < count; i++)
+	{
+		SimParticle particle = Read(i);
+		column[i] = ToWord(particle.position.x);
+		column[count + i] = ToWord(particle.position.y);
+		column[count * 2 + i] = ToWord(particle.velocity.x);
+		column[count * 3 + i] = ToWord(particle.velocity.y);
+		column[count * 4 + i] = ToWord(particle.rotation);
+		column[count * 5 + i] = ToWord(particle.rotationVelocity);
+		column[count * 6 + i] = ToWord(particle.age);
+		column[count * 7 + i] = ToWord(particle.lifetime);
+		column[count * 8 + i] = ToWord(particle.sizeFactor);
+	}
+}
+
+bool ParticleSystem::LoadState(const uint32_t* words, size_t size)
+{
+	if (size < STATE_HEADER_WORDS)
+		return false;
+
+	size_t savedCount = words[5];
+	if (size != STATE_HEADER_WORDS + savedCount * STATE_PARTICLE_WORDS)
+		return false;
+
+	// Blocks this system already holds are reused, false if the pool can't cover the rest
+	size_t neededBlocks = (savedCount + ParticlePool::BLOCK_SIZE - 1) / ParticlePool::BLOCK_SIZE;
+	if (neededBlocks > blocks.size() + pool->GetFreeBlockCount())
+		return false;
+	ReleaseBlocks(neededBlocks);
+	while (blocks.size() < neededBlocks)
+		blocks.push_back(pool->Allocate());
+
+	uint64_t timeBits = words[2] | ((uint64_t)words[3] << 32);
+	random.SetState(words[0] | ((uint64_t)words[1] << 32));
+	std::memcpy(&time, &timeBits, sizeof(time));
+	spawnTimer = FromWord<float>(words[4]);
+	count = savedCount;
+
+	const uint32_t* column = words + STATE_HEADER_WORDS;
+	for (size_t i = 0; i < count; i++)
+	{
+		SimParticle particle;
+		particle.position.x = FromWord<float>(column[i]);
+		particle.position.y = FromWord<float>(column[count + i]);
+		particle.velocity.x = FromWord<float>(column[count * 2 + i]);
+		particle.velocity.y = FromWord<float>(column[count * 3 + i]);
+		particle.rotation = FromWord<float>(column[count * 4 + i]);
+		particle.rotationVelocity = FromWord<float>(column[count * 5 + i]);
+		particle.age = FromWord<float>(column[count * 6 + i]);
+		particle.lifetime = FromWord<float>(column[count * 7 + i]);
+		particle.sizeFactor = FromWord<float>(column[count * 8 + i]);
+		particle.previousPosition = particle.position;
+		particle.previousRotation = particle.rotation;
+		Write(i, particle);
+	}
+	colorsCurrent = false;
+	return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "EmitterSettings.h"
+#include "ParticlePool.h"
+#include "Random.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One particle as drawn: interpolated center, size, rotation in degrees and color
+struct ParticleInstance
+{
+	float x;
+	float y;
+	float width;
+	float height;
+	float rotation;
+	Color color;
+};
+
+// Editor side particle simulation driven by the same properties as Difu's
+// ParticleEmitter. All randomness comes from a seeded Random and particles
+// live in blocks of a preallocated ParticlePool, so a given seed and sequence
+// of steps always produces the same state. Particle i is slot i % BLOCK_SIZE
+// of block i / BLOCK_SIZE, only the last block is partly used.
+class ParticleSystem
+{
+public:
+	// Without a pool the system gets one of its own with the default budget
+	explicit ParticleSystem(ParticlePool* pool = nullptr);
+	~ParticleSystem();
+
+	ParticleSystem(const ParticleSystem&) = delete;
+	ParticleSystem& operator=(const ParticleSystem&) = delete;
+	ParticleSystem(ParticleSystem&& other) noexcept;
+	ParticleSystem& operator=(ParticleSystem&& other) noexcept;
+
+	// Removes every particle and restarts the clock and the random sequence
+	void Reset(uint64_t seed);
+	void Step(const EmitterSettings& settings, float dt);
+
+	// Step split into its phases, for stepping on several threads. Integrating
+	// disjoint block ranges and compacting different systems may run at the
+	// same time, FinishStep touches the shared pool and runs one system at a time.
+	void IntegrateBlocks(const EmitterSettings& settings, float dt, size_t first, size_t end);
+	// Removes expired particles but keeps their blocks until FinishStep
+	void Compact();
+	// Advances the clock, returns unused blocks and spawns
+	void FinishStep(const EmitterSettings& settings, float dt);
+	// alpha blends between the previous and the current step. Draws each
+	// particle through raylib's batch, see ParticleRenderer for the faster path.
+	void Render(const EmitterSettings& settings, float alpha = 1.0f) const;
+	// Fills instances with block index's particles as drawn, returns how many.
+	// instances needs room for a whole block.
+	size_t GetInstances(size_t index, const EmitterSettings& settings, float alpha, ParticleInstance* instances) const;
+
+	size_t GetCount() const;
+	// Capacity of the whole pool, shared with the other systems using it
+	size_t GetCapacity() const;
+	double GetTime() const;
+	// Blocks in particle order, count is set to how many of the block's particles are alive
+	size_t GetBlockCount() const;
+	// Only for the pool's layout
+	const SimParticle* GetBlock(size_t index, size_t* count) const;
+	const SoaParticleBlock* GetSoaBlock(size_t index, size_t* count) const;
+	ParticleLayout GetLayout() const;
+	// Hash of the state that affects later steps, equal hashes mean identical runs
+	uint64_t GetStateHash() const;
+
+	// Everything later steps depend on, as 32 bit words. Restoring and stepping
+	// gives exactly the same particles as never having saved.
+	void SaveState(std::vector<uint32_t>* state) const;
+	bool LoadState(const uint32_t* state, size_t size);
+	// FNV-1a over saved state words
+	static uint64_t HashState(const std::vector<uint32_t>& state);
+
+private:
+	// Per particle access that works with either layout
+	SimParticle Read(size_t index) const;
+	void Write(size_t index, const SimParticle& particle);
+	void Move(size_t from, size_t to);
+	static Color GetColor(const EmitterSettings& settings, float age, float lifetime);
+	// Hands blocks past the last particle back to the pool
+	void ReleaseBlocks(size_t keep);
+
+	void Spawn(const EmitterSettings& settings, float dt);
+
+	std::unique_ptr<ParticlePool> ownPool;
+	ParticlePool* pool;
+	// Reserved for the whole pool up front, so taking a block never reallocates
+	std::vector<uint32_t> blocks;
+	size_t count = 0;
+	float spawnTimer = 0.0f;
+	double time = 0.0;
+	Random random;
+	// False after LoadState, the StructOfArrays colors are only filled in by Step
+	bool colorsCurrent = true;
+};
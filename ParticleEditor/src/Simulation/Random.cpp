@@ -0,0 +1,47 @@
+#include "Random.h"
+
+static constexpr uint64_t MULTIPLIER = 6364136223846793005ull;
+static constexpr uint64_t INCREMENT = 1442695040888963407ull;
+
+Random::Random(uint64_t seed)
+{
+	Seed(seed);
+}
+
+void Random::Seed(uint64_t seed)
+{
+	state = 0;
+	Next();
+	state += seed;
+	Next();
+}
+
+uint32_t Random::Next()
+{
+	uint64_t old = state;
+	state = old * MULTIPLIER + INCREMENT;
+	uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+	uint32_t rotation = (uint32_t)(old >> 59);
+	return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+float Random::Float()
+{
+	// 24 bits fill the float mantissa exactly, so the result never rounds up to 1
+	return (Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float Random::Range(float min, float max)
+{
+	return min + (max - min) * Float();
+}
+
+uint64_t Random::GetState() const
+{
+	return state;
+}
+
+void Random::SetState(uint64_t _state)
+{
+	state = _state;
+}
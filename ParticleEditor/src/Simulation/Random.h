@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// PCG32 generator. Unlike raylib's GetRandomValue its whole state is this
+// object, so a seeded simulation is reproducible and can be snapshotted.
+class Random
+{
+public:
+	explicit Random(uint64_t seed = 1);
+
+	void Seed(uint64_t seed);
+
+	uint32_t Next();
+	// Uniform in [0, 1)
+	float Float();
+	// Uniform in [min, max)
+	float Range(float min, float max);
+
+	uint64_t GetState() const;
+	void SetState(uint64_t state);
+
+private:
+	uint64_t state = 0;
+};
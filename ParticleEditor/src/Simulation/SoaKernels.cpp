@@ -0,0 +1,254 @@
+#include "SoaKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SOA_KERNELS_X86
+	#include <immintrin.h>
+#endif
+
+namespace SoaKernels
+{
+	static Level level = GetSupportedLevel();
+
+	Level GetSupportedLevel()
+	{
+#ifdef SOA_KERNELS_X86
+		// Also runs from static initialization, before libgcc may have read cpuid itself
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return Level::AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return Level::SSE;
+#endif
+		return Level::Scalar;
+	}
+
+	const char* GetName(Level _level)
+	{
+		switch (_level)
+		{
+		case Level::Scalar: return "Scalar";
+		case Level::SSE:    return "SSE";
+		case Level::AVX2:   return "AVX2";
+		default:            return "Unknown";
+		}
+	}
+
+	Level GetLevel()
+	{
+		return level;
+	}
+
+	void SetLevel(Level _level)
+	{
+		level = std::min(_level, GetSupportedLevel());
+	}
+
+	// Color channels as floats, the difference is taken in float like ParticleSystem::Render does
+	struct ColorLerp
+	{
+		float start[4];
+		float delta[4];
+
+		explicit ColorLerp(const EmitterSettings& settings)
+		{
+			Color from = settings.startColor;
+			Color to = settings.endColor;
+			unsigned char starts[4] = {from.r, from.g, from.b, from.a};
+			unsigned char ends[4] = {to.r, to.g, to.b, to.a};
+			for (int i = 0; i < 4; i++)
+			{
+				start[i] = starts[i];
+				delta[i] = (float)(ends[i] - starts[i]);
+			}
+		}
+	};
+
+	static void IntegrateScalar(SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt)
+	{
+		ColorLerp color(settings);
+		for (size_t i = 0; i < count; i++)
+		{
+			block->previousX[i] = block->positionX[i];
+			block->previousY[i] = block->positionY[i];
+			block->previousRotation[i] = block->rotation[i];
+
+			float accelerationX = settings.acceleration.x;
+			float accelerationY = settings.acceleration.y;
+			if (settings.centripetalAcceleration != 0.0f)
+			{
+				float dx = settings.spawnPosition.x - block->positionX[i];
+				float dy = settings.spawnPosition.y - block->positionY[i];
+				float length = std::sqrt(dx * dx + dy * dy);
+				if (length > 0.0001f)
+				{
+					accelerationX += dx / length * settings.centripetalAcceleration;
+					accelerationY += dy / length * settings.centripetalAcceleration;
+				}
+			}
+
+			block->velocityX[i] += accelerationX * dt;
+			block->velocityY[i] += accelerationY * dt;
+			block->positionX[i] += block->velocityX[i] * dt;
+			block->positionY[i] += block->velocityY[i] * dt;
+			block->rotationVelocity[i] += settings.rotationAcceleration * dt;
+			block->rotation[i] += block->rotationVelocity[i] * dt;
+			block->age[i] += dt;
+
+			float t = block->lifetime[i] > 0.0f ? std::min(block->age[i] / block->lifetime[i], 1.0f) : 1.0f;
+			block->colorR[i] = color.start[0] + color.delta[0] * t;
+			block->colorG[i] = color.start[1] + color.delta[1] * t;
+			block->colorB[i] = color.start[2] + color.delta[2] * t;
+			block->colorA[i] = color.start[3] + color.delta[3] * t;
+		}
+	}
+
+#ifdef SOA_KERNELS_X86
+	// Masks pick between results instead of adding zero, so signed zeros match the scalar branch too
+	static inline __m128 Select(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+	}
+
+	static void IntegrateSSE(SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt)
+	{
+		ColorLerp color(settings);
+		const __m128 step = _mm_set1_ps(dt);
+		const __m128 accelerationX = _mm_set1_ps(settings.acceleration.x);
+		const __m128 accelerationY = _mm_set1_ps(settings.acceleration.y);
+		const __m128 centripetal = _mm_set1_ps(settings.centripetalAcceleration);
+		const __m128 spawnX = _mm_set1_ps(settings.spawnPosition.x);
+		const __m128 spawnY = _mm_set1_ps(settings.spawnPosition.y);
+		const __m128 rotationAcceleration = _mm_set1_ps(settings.rotationAcceleration * dt);
+		const __m128 minLength = _mm_set1_ps(0.0001f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const bool pulls = settings.centripetalAcceleration != 0.0f;
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 positionX = _mm_load_ps(block->positionX + i);
+			__m128 positionY = _mm_load_ps(block->positionY + i);
+			__m128 rotation = _mm_load_ps(block->rotation + i);
+			_mm_store_ps(block->previousX + i, positionX);
+			_mm_store_ps(block->previousY + i, positionY);
+			_mm_store_ps(block->previousRotation + i, rotation);
+
+			__m128 ax = accelerationX;
+			__m128 ay = accelerationY;
+			if (pulls)
+			{
+				__m128 dx = _mm_sub_ps(spawnX, positionX);
+				__m128 dy = _mm_sub_ps(spawnY, positionY);
+				__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+				__m128 far = _mm_cmpgt_ps(length, minLength);
+				ax = Select(far, _mm_add_ps(ax, _mm_mul_ps(_mm_div_ps(dx, length), centripetal)), ax);
+				ay = Select(far, _mm_add_ps(ay, _mm_mul_ps(_mm_div_ps(dy, length), centripetal)), ay);
+			}
+
+			__m128 velocityX = _mm_add_ps(_mm_load_ps(block->velocityX + i), _mm_mul_ps(ax, step));
+			__m128 velocityY = _mm_add_ps(_mm_load_ps(block->velocityY + i), _mm_mul_ps(ay, step));
+			_mm_store_ps(block->velocityX + i, velocityX);
+			_mm_store_ps(block->velocityY + i, velocityY);
+			_mm_store_ps(block->positionX + i, _mm_add_ps(positionX, _mm_mul_ps(velocityX, step)));
+			_mm_store_ps(block->positionY + i, _mm_add_ps(positionY, _mm_mul_ps(velocityY, step)));
+
+			__m128 rotationVelocity = _mm_add_ps(_mm_load_ps(block->rotationVelocity + i), rotationAcceleration);
+			_mm_store_ps(block->rotationVelocity + i, rotationVelocity);
+			_mm_store_ps(block->rotation + i, _mm_add_ps(rotation, _mm_mul_ps(rotationVelocity, step)));
+
+			__m128 age = _mm_add_ps(_mm_load_ps(block->age + i), step);
+			__m128 lifetime = _mm_load_ps(block->lifetime + i);
+			_mm_store_ps(block->age + i, age);
+
+			__m128 t = Select(_mm_cmpgt_ps(lifetime, zero), _mm_min_ps(_mm_div_ps(age, lifetime), one), one);
+			_mm_store_ps(block->colorR + i, _mm_add_ps(_mm_set1_ps(color.start[0]), _mm_mul_ps(_mm_set1_ps(color.delta[0]), t)));
+			_mm_store_ps(block->colorG + i, _mm_add_ps(_mm_set1_ps(color.start[1]), _mm_mul_ps(_mm_set1_ps(color.delta[1]), t)));
+			_mm_store_ps(block->colorB + i, _mm_add_ps(_mm_set1_ps(color.start[2]), _mm_mul_ps(_mm_set1_ps(color.delta[2]), t)));
+			_mm_store_ps(block->colorA + i, _mm_add_ps(_mm_set1_ps(color.start[3]), _mm_mul_ps(_mm_set1_ps(color.delta[3]), t)));
+		}
+	}
+
+	// No FMA on purpose, a fused multiply-add rounds differently from the scalar code
+	__attribute__((target("avx2")))
+	static void IntegrateAVX2(SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt)
+	{
+		ColorLerp color(settings);
+		const __m256 step = _mm256_set1_ps(dt);
+		const __m256 accelerationX = _mm256_set1_ps(settings.acceleration.x);
+		const __m256 accelerationY = _mm256_set1_ps(settings.acceleration.y);
+		const __m256 centripetal = _mm256_set1_ps(settings.centripetalAcceleration);
+		const __m256 spawnX = _mm256_set1_ps(settings.spawnPosition.x);
+		const __m256 spawnY = _mm256_set1_ps(settings.spawnPosition.y);
+		const __m256 rotationAcceleration = _mm256_set1_ps(settings.rotationAcceleration * dt);
+		const __m256 minLength = _mm256_set1_ps(0.0001f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const bool pulls = settings.centripetalAcceleration != 0.0f;
+
+		for (size_t i = 0; i < count; i += 8)
+		{
+			__m256 positionX = _mm256_load_ps(block->positionX + i);
+			__m256 positionY = _mm256_load_ps(block->positionY + i);
+			__m256 rotation = _mm256_load_ps(block->rotation + i);
+			_mm256_store_ps(block->previousX + i, positionX);
+			_mm256_store_ps(block->previousY + i, positionY);
+			_mm256_store_ps(block->previousRotation + i, rotation);
+
+			__m256 ax = accelerationX;
+			__m256 ay = accelerationY;
+			if (pulls)
+			{
+				__m256 dx = _mm256_sub_ps(spawnX, positionX);
+				__m256 dy = _mm256_sub_ps(spawnY, positionY);
+				__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+				__m256 far = _mm256_cmp_ps(length, minLength, _CMP_GT_OQ);
+				ax = _mm256_blendv_ps(ax, _mm256_add_ps(ax, _mm256_mul_ps(_mm256_div_ps(dx, length), centripetal)), far);
+				ay = _mm256_blendv_ps(ay, _mm256_add_ps(ay, _mm256_mul_ps(_mm256_div_ps(dy, length), centripetal)), far);
+			}
+
+			__m256 velocityX = _mm256_add_ps(_mm256_load_ps(block->velocityX + i), _mm256_mul_ps(ax, step));
+			__m256 velocityY = _mm256_add_ps(_mm256_load_ps(block->velocityY + i), _mm256_mul_ps(ay, step));
+			_mm256_store_ps(block->velocityX + i, velocityX);
+			_mm256_store_ps(block->velocityY + i, velocityY);
+			_mm256_store_ps(block->positionX + i, _mm256_add_ps(positionX, _mm256_mul_ps(velocityX, step)));
+			_mm256_store_ps(block->positionY + i, _mm256_add_ps(positionY, _mm256_mul_ps(velocityY, step)));
+
+			__m256 rotationVelocity = _mm256_add_ps(_mm256_load_ps(block->rotationVelocity + i), rotationAcceleration);
+			_mm256_store_ps(block->rotationVelocity + i, rotationVelocity);
+			_mm256_store_ps(block->rotation + i, _mm256_add_ps(rotation, _mm256_mul_ps(rotationVelocity, step)));
+
+			__m256 age = _mm256_add_ps(_mm256_load_ps(block->age + i), step);
+			__m256 lifetime = _mm256_load_ps(block->lifetime + i);
+			_mm256_store_ps(block->age + i, age);
+
+			__m256 t = _mm256_blendv_ps(one, _mm256_min_ps(_mm256_div_ps(age, lifetime), one), _mm256_cmp_ps(lifetime, zero, _CMP_GT_OQ));
+			_mm256_store_ps(block->colorR + i, _mm256_add_ps(_mm256_set1_ps(color.start[0]), _mm256_mul_ps(_mm256_set1_ps(color.delta[0]), t)));
+			_mm256_store_ps(block->colorG + i, _mm256_add_ps(_mm256_set1_ps(color.start[1]), _mm256_mul_ps(_mm256_set1_ps(color.delta[1]), t)));
+			_mm256_store_ps(block->colorB + i, _mm256_add_ps(_mm256_set1_ps(color.start[2]), _mm256_mul_ps(_mm256_set1_ps(color.delta[2]), t)));
+			_mm256_store_ps(block->colorA + i, _mm256_add_ps(_mm256_set1_ps(color.start[3]), _mm256_mul_ps(_mm256_set1_ps(color.delta[3]), t)));
+		}
+	}
+#endif
+
+	void Integrate(SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt)
+	{
+		Integrate(level, block, count, settings, dt);
+	}
+
+	void Integrate(Level _level, SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt)
+	{
+#ifdef SOA_KERNELS_X86
+		// The block size is a multiple of 8, rounding up never leaves the arrays
+		if (_level == Level::AVX2)
+			return IntegrateAVX2(block, (count + 7) & ~(size_t)7, settings, dt);
+		if (_level == Level::SSE)
+			return IntegrateSSE(block, (count + 3) & ~(size_t)3, settings, dt);
+#else
+		(void)_level;
+#endif
+		IntegrateScalar(block, count, settings, dt);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "EmitterSettings.h"
+#include "ParticlePool.h"
+
+#include <cstddef>
+
+// Update kernels for StructOfArrays pool blocks. Every level does the same
+// float operations in the same order as ParticleSystem's scalar update, so
+// they all give bit-identical particles and only differ in speed.
+namespace SoaKernels
+{
+	enum class Level
+	{
+		Scalar,
+		SSE,
+		AVX2,
+		COUNT
+	};
+
+	// Best level this CPU runs, Scalar on other architectures
+	Level GetSupportedLevel();
+	const char* GetName(Level level);
+
+	// Used by ParticleSystem, starts at the supported level and is clamped to it
+	Level GetLevel();
+	void SetLevel(Level level);
+
+	// Integrates the first count particles and lerps their color by age. SIMD
+	// levels work in whole vectors and also update lanes up to the next multiple of 8.
+	void Integrate(SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt);
+	// level has to be supported by this CPU
+	void Integrate(Level level, SoaParticleBlock* block, size_t count, const EmitterSettings& settings, float dt);
+}
@@ -1,70 +1,110 @@
 #include "ConsoleLog.h"
 
+#include <algorithm>
+
 ConsoleLog::ConsoleLog()
 {
+	SetCapacity(DEFAULT_CAPACITY);
 }
 
-void ConsoleLog::Load(Rectangle _destination, float _messageLifetime, Color _messageColor)
+void ConsoleLog::Load(Rectangle _destination, float _messageLifetime, Color _messageColor, size_t capacity)
 {
 	messageColor = _messageColor;
 	messageLifetime = _messageLifetime;
 	destination = _destination;
-	outputTexture = LoadRenderTexture(destination.width, destination.height);
+	SetCapacity(capacity);
+	output.Resize(destination.width, destination.height);
+	dirty = true;
 }
 
 void ConsoleLog::Unload()
 {
-	UnloadRenderTexture(outputTexture);
+	output.Unload();
 }
 
-void ConsoleLog::Print(const std::string &value)
+void ConsoleLog::Print(std::string value)
 {
-	std::pair<float, std::string> toAdd;
-	toAdd.first = messageLifetime;
-	toAdd.second = value;
-	content.emplace_back(toAdd);
+	if (!pending.TryPush(std::move(value)))
+		dropped++;
+}
+
+void ConsoleLog::Append(std::string&& value)
+{
+	if (count == messages.size())
+	{
+		// Full, overwrite the oldest
+		tail = (tail + 1) % messages.size();
+		count--;
+		dropped++;
+	}
+
+	Message& message = messages[(tail + count) % messages.size()];
+	message.arrival = clock;
+	message.text = std::move(value);
+	count++;
+	dirty = true;
 }
 
 void ConsoleLog::Update(float dt)
 {
-	if (content.size() > 0)
+	clock += dt;
+
+	std::string value;
+	while (pending.TryPop(&value))
+		Append(std::move(value));
+
+	// Messages arrive in order, so expired ones are always at the tail
+	while (count > 0 && clock - messages[tail].arrival > messageLifetime)
 	{
-		for (int i = content.size() - 1; i >= 0; i--)
-		{
-			content[i].first -= dt;
-			if (content[i].first < 0.0f)
-				content.erase(content.begin() + i);
-		}
+		tail = (tail + 1) % messages.size();
+		count--;
+		dirty = true;
 	}
 }
 
+const ConsoleLog::Message& ConsoleLog::GetMessage(size_t index) const
+{
+	return messages[(tail + index) % messages.size()];
+}
+
 void ConsoleLog::Render(bool bottom_is_latest)
 {
-	if (content.size() < 1)
+	if (count < 1)
 		return;
 
-	int beginY = 0;
-	int increment = 20;
-	if (bottom_is_latest)
+	// Only re-rasterize when the messages or the layout changed, otherwise reuse the texture
+	if (dirty || bottom_is_latest != renderedBottomIsLatest)
 	{
-		beginY = destination.height - increment;
-		increment *= -1;
-	}
+		int beginY = 0;
+		int increment = 20;
+		if (bottom_is_latest)
+		{
+			beginY = destination.height - increment;
+			increment *= -1;
+		}
 
-	BeginTextureMode(outputTexture);
-	ClearBackground({0, 0, 0, 0});
-	for (int i = content.size() - 1; i >= 0; i--)
-	{
-		DrawText(content[i].second.c_str(), 0, beginY + increment * i, 20, messageColor);	
+		// Lines past the texture would be clipped anyway
+		int visible = std::min<int>(count, destination.height / 20 + 1);
+
+		output.Begin();
+		ClearBackground({0, 0, 0, 0});
+		for (int i = visible - 1; i >= 0; i--)
+		{
+			DrawText(GetMessage(i).text.c_str(), 0, beginY + increment * i, 20, messageColor);	
+		}
+		output.End();
+
+		dirty = false;
+		renderedBottomIsLatest = bottom_is_latest;
 	}
-	EndTextureMode();
 
-	DrawTexturePro(outputTexture.texture, {0.0f, 0.0f, destination.width, -destination.height}, destination, {0.0f, 0.0f}, 0.0f, WHITE);
+	DrawTexturePro(output.GetTexture(), output.GetSourceRect(), destination, {0.0f, 0.0f}, 0.0f, WHITE);
 }
 
 void ConsoleLog::SetMessageColor(Color color)
 {
 	messageColor = color;
+	dirty = true;
 }
 
 void ConsoleLog::SetMessageLifetime(float lifetime)
@@ -75,6 +115,34 @@ void ConsoleLog::SetMessageLifetime(float lifetime)
 void ConsoleLog::SetDestinationBounds(Rectangle bounds)
 {
 	destination = bounds;
-	UnloadRenderTexture(outputTexture);
-	outputTexture = LoadRenderTexture(destination.width, destination.height);
+	output.Resize(destination.width, destination.height);
+	dirty = true;
+}
+
+void ConsoleLog::SetCapacity(size_t capacity)
+{
+	capacity = std::max<size_t>(capacity, 1);
+	if (capacity == messages.size())
+		return;
+
+	std::vector<Message> resized(capacity);
+	size_t kept = std::min(count, capacity);
+	dropped += count - kept;
+	for (size_t i = 0; i < kept; i++)
+		resized[i] = std::move(messages[(tail + count - kept + i) % messages.size()]);
+
+	messages = std::move(resized);
+	tail = 0;
+	count = kept;
+	dirty = true;
+}
+
+size_t ConsoleLog::GetCapacity() const
+{
+	return messages.size();
+}
+
+size_t ConsoleLog::GetDroppedCount() const
+{
+	return dropped;
 }
@@ -1,18 +1,26 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <raylib.h>
 
+#include "MpscQueue.h"
+#include "RenderTarget.h"
+
 class ConsoleLog
 {
 public:
+	static constexpr size_t DEFAULT_CAPACITY = 64;
+	static constexpr size_t PENDING_CAPACITY = 1024;
+
 	ConsoleLog();
 
-	void Load(Rectangle destination, float messageLifetime, Color messageColor);
+	void Load(Rectangle destination, float messageLifetime, Color messageColor, size_t capacity = DEFAULT_CAPACITY);
 	void Unload();
 
-	void Print(const std::string& value);
+	// Safe to call from any thread, never blocks. Messages show up at the next Update.
+	void Print(std::string value);
 
 	void Update(float dt);
 	void Render(bool bottom_is_latest);
@@ -20,11 +28,39 @@ public:
 	void SetMessageColor(Color color);
 	void SetMessageLifetime(float lifetime);
 	void SetDestinationBounds(Rectangle bounds);
+	// Drops the oldest messages if the new capacity is smaller
+	void SetCapacity(size_t capacity);
+
+	size_t GetCapacity() const;
+	// Messages lost because the buffer or the pending queue was full
+	size_t GetDroppedCount() const;
 
 private:
-	std::vector<std::pair<float, std::string>> content;
+	struct Message
+	{
+		float arrival = 0.0f;
+		std::string text;
+	};
+
+	void Append(std::string&& value);
+	const Message& GetMessage(size_t index) const;
+
+	// Filled by Print from any thread, drained on the main thread by Update
+	MpscQueue<std::string> pending{PENDING_CAPACITY};
+
+	// Ring buffer, oldest message at tail
+	std::vector<Message> messages;
+	size_t tail = 0;
+	size_t count = 0;
+	std::atomic<size_t> dropped = 0;
+	float clock = 0.0f;
+
+	// output is out of date
+	bool dirty = true;
+	bool renderedBottomIsLatest = false;
+
 	float messageLifetime = 5.0f;
 	Color messageColor = BLACK;
 	Rectangle destination = {0.0f, 0.0f, 100.0f, 100.0f};
-	RenderTexture2D outputTexture;
+	RenderTarget output;
 };
@@ -0,0 +1,94 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::Update(float dt, float renderMilliseconds)
+{
+	// Restarted on every scale change, times from the old scale would skew it
+	if (averageMilliseconds <= 0.0f)
+		averageMilliseconds = renderMilliseconds;
+	else
+		averageMilliseconds += (renderMilliseconds - averageMilliseconds) * 0.1f;
+
+	if (!enabled)
+		return;
+
+	sinceAdjust += dt;
+	if (sinceAdjust < ADJUST_INTERVAL)
+		return;
+	sinceAdjust = 0.0f;
+
+	if (averageMilliseconds <= targetMilliseconds)
+		lowerBlocked = false;
+
+	// Fewer pixels have to save at least a tenth, otherwise the cost isn't in the pixels
+	if (millisecondsBeforeDecrease > 0.0f)
+	{
+		bool helped = averageMilliseconds < millisecondsBeforeDecrease * 0.9f;
+		millisecondsBeforeDecrease = 0.0f;
+		if (!helped)
+		{
+			scale = scaleBeforeDecrease;
+			averageMilliseconds = 0.0f;
+			lowerBlocked = true;
+			return;
+		}
+	}
+
+	if (averageMilliseconds <= targetMilliseconds && averageMilliseconds >= targetMilliseconds * HEADROOM)
+		return;
+	if (averageMilliseconds > targetMilliseconds && lowerBlocked)
+		return;
+
+	float wanted = scale * std::sqrt(targetMilliseconds / std::max(averageMilliseconds, 0.01f));
+	float newScale = std::clamp(std::round(wanted / SCALE_STEP) * SCALE_STEP, MIN_SCALE, 1.0f);
+	if (newScale != scale)
+	{
+		if (newScale < scale)
+		{
+			millisecondsBeforeDecrease = averageMilliseconds;
+			scaleBeforeDecrease = scale;
+		}
+		scale = newScale;
+		averageMilliseconds = 0.0f;
+	}
+}
+
+void DynamicResolution::SetEnabled(bool _enabled)
+{
+	enabled = _enabled;
+	millisecondsBeforeDecrease = 0.0f;
+	lowerBlocked = false;
+	if (!enabled && scale != 1.0f)
+	{
+		scale = 1.0f;
+		averageMilliseconds = 0.0f;
+	}
+}
+
+void DynamicResolution::SetTargetMilliseconds(float milliseconds)
+{
+	targetMilliseconds = std::max(milliseconds, 0.1f);
+	lowerBlocked = false;
+}
+
+bool DynamicResolution::IsEnabled() const
+{
+	return enabled;
+}
+
+float DynamicResolution::GetTargetMilliseconds() const
+{
+	return targetMilliseconds;
+}
+
+float DynamicResolution::GetScale() const
+{
+	return scale;
+}
+
+float DynamicResolution::GetAverageMilliseconds() const
+{
+	return averageMilliseconds;
+}
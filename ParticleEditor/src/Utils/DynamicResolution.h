@@ -0,0 +1,45 @@
+#pragma once
+
+// Picks the fraction of the full resolution to render at so that rendering
+// stays within a time budget. Meant for CPU rendering timed as it happens,
+// its cost is assumed to grow with the pixel count, so the scale follows the
+// square root of budget / measured time. It only moves in SCALE_STEP steps a
+// few times a second, so textures sized from it aren't recreated every frame.
+// A decrease that doesn't make rendering faster is undone and the scale stays
+// there until the time changes on its own.
+class DynamicResolution
+{
+public:
+	static constexpr float MIN_SCALE = 0.25f;
+	static constexpr float SCALE_STEP = 0.05f;
+	// Seconds between adjustments
+	static constexpr float ADJUST_INTERVAL = 0.25f;
+	// Scales up again once the time falls under this fraction of the target
+	static constexpr float HEADROOM = 0.75f;
+	static constexpr float DEFAULT_TARGET_MILLISECONDS = 8.0f;
+
+	// Called with the time this frame's rendering took at the current scale
+	void Update(float dt, float renderMilliseconds);
+
+	void SetEnabled(bool enabled);
+	void SetTargetMilliseconds(float milliseconds);
+
+	bool IsEnabled() const;
+	float GetTargetMilliseconds() const;
+	// 1 while disabled
+	float GetScale() const;
+	// Smoothed render time since the scale last changed
+	float GetAverageMilliseconds() const;
+
+private:
+	bool enabled = false;
+	float targetMilliseconds = DEFAULT_TARGET_MILLISECONDS;
+	float scale = 1.0f;
+	float averageMilliseconds = 0.0f;
+	float sinceAdjust = 0.0f;
+	// Time and scale before the last decrease, 0 once it has been judged
+	float millisecondsBeforeDecrease = 0.0f;
+	float scaleBeforeDecrease = 1.0f;
+	// Set when a decrease didn't help, until the time falls under the target
+	bool lowerBlocked = false;
+};
@@ -0,0 +1,242 @@
+#include "EmitterBank.h"
+
+#include <cstring>
+#include <cerrno>
+
+#include <Difu/Utils/Logger.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOGDI
+	#define NOUSER
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+static const unsigned char BANK_MAGIC[4] = {'P', 'E', 'B', 'K'};
+
+static uint32_t ReadU32(const unsigned char* in)
+{
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint64_t ReadU64(const unsigned char* in)
+{
+	return (uint64_t)ReadU32(in) | ((uint64_t)ReadU32(in + 4) << 32);
+}
+
+EmitterBank::EmitterBank()
+{
+}
+
+EmitterBank::~EmitterBank()
+{
+	Close();
+}
+
+bool EmitterBank::Open(const std::string& _filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(_filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		Logger::Error("Could not open {}: error {}", _filename, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Logger::Error("Could not map {}: empty file", _filename);
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		Logger::Error("Could not map {}: error {}", _filename, GetLastError());
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const unsigned char*)view;
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(_filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		Logger::Error("Could not open {}: {}", _filename, std::strerror(errno));
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		Logger::Error("Could not map {}: empty file", _filename);
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps the file alive
+	close(fd);
+	if (view == MAP_FAILED)
+	{
+		Logger::Error("Could not map {}: {}", _filename, std::strerror(errno));
+		return false;
+	}
+
+	data = (const unsigned char*)view;
+	size = info.st_size;
+#endif
+
+	filename = _filename;
+	if (!Validate())
+	{
+		Logger::Error("{} is not a valid emitter bank", _filename);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void EmitterBank::Close()
+{
+	if (data)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)mappingHandle);
+		CloseHandle((HANDLE)fileHandle);
+		mappingHandle = nullptr;
+		fileHandle = nullptr;
+#else
+		munmap((void*)data, size);
+#endif
+	}
+
+	data = nullptr;
+	size = 0;
+	count = 0;
+	slotCount = 0;
+	entries = nullptr;
+	slots = nullptr;
+	filename.clear();
+}
+
+bool EmitterBank::Validate()
+{
+	if (size < HEADER_SIZE || std::memcmp(data, BANK_MAGIC, 4) != 0)
+		return false;
+
+	unsigned short version = (unsigned short)(data[4] | (data[5] << 8));
+	if (version > VERSION)
+	{
+		Logger::Error("Unsupported bank version {} (newest known is {})", version, VERSION);
+		return false;
+	}
+
+	count = ReadU32(data + 8);
+	slotCount = ReadU32(data + 12);
+	size_t entriesOffset = ReadU32(data + 16);
+	size_t slotsOffset = ReadU32(data + 20);
+
+	if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || slotCount < count)
+		return false;
+	if (entriesOffset + count * ENTRY_SIZE > size || slotsOffset + slotCount * SLOT_SIZE > size)
+		return false;
+
+	entries = data + entriesOffset;
+	slots = data + slotsOffset;
+
+	// Entries are checked once here so lookups can trust the offsets
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned char* entry = entries + i * ENTRY_SIZE;
+		if ((size_t)ReadU32(entry) + ReadU32(entry + 4) > size || (size_t)ReadU32(entry + 8) + ReadU32(entry + 12) > size)
+			return false;
+	}
+
+	return true;
+}
+
+bool EmitterBank::IsOpen() const
+{
+	return data != nullptr;
+}
+
+const std::string& EmitterBank::GetFilename() const
+{
+	return filename;
+}
+
+size_t EmitterBank::GetCount() const
+{
+	return count;
+}
+
+std::string_view EmitterBank::GetName(size_t index) const
+{
+	if (index >= count)
+		return {};
+
+	const unsigned char* entry = entries + index * ENTRY_SIZE;
+	return std::string_view((const char*)data + ReadU32(entry), ReadU32(entry + 4));
+}
+
+const unsigned char* EmitterBank::GetRecord(size_t index, size_t* record_size) const
+{
+	if (index >= count)
+		return nullptr;
+
+	const unsigned char* entry = entries + index * ENTRY_SIZE;
+	if (record_size)
+		*record_size = ReadU32(entry + 12);
+	return data + ReadU32(entry + 8);
+}
+
+const unsigned char* EmitterBank::Find(std::string_view name, size_t* record_size) const
+{
+	if (!data)
+		return nullptr;
+
+	uint64_t hash = Hash(name);
+	size_t mask = slotCount - 1;
+	for (size_t probe = 0; probe < slotCount; probe++)
+	{
+		const unsigned char* slot = slots + ((hash + probe) & mask) * SLOT_SIZE;
+		uint32_t entryIndex = ReadU32(slot + 8);
+		if (entryIndex == 0)
+			return nullptr;
+
+		if (ReadU64(slot) == hash && GetName(entryIndex - 1) == name)
+			return GetRecord(entryIndex - 1, record_size);
+	}
+
+	return nullptr;
+}
+
+uint64_t EmitterBank::Hash(std::string_view name)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (char ch : name)
+	{
+		hash ^= (unsigned char)ch;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only view of a bank file: many binary emitter records packed behind a
+// name hash index. The file is memory mapped so only touched pages are loaded.
+//
+// Layout (little-endian):
+//   header  : "PEBK" magic, u16 version, u16 reserved, u32 emitter count, u32 slot count,
+//             u32 entries offset, u32 slots offset, u32 names offset, u32 reserved
+//   entries : emitter count * { u32 name offset, u32 name length, u32 record offset, u32 record size }
+//   slots   : slot count (power of two) * { u64 name hash, u32 entry index + 1 (0 = empty), u32 reserved }
+//   names   : concatenated emitter names
+//   records : binary emitter records (see ParticleSerializer::EncodeBinary)
+class EmitterBank
+{
+public:
+	static constexpr size_t HEADER_SIZE = 32;
+	static constexpr size_t ENTRY_SIZE = 16;
+	static constexpr size_t SLOT_SIZE = 16;
+	static constexpr unsigned short VERSION = 1;
+
+	EmitterBank();
+	~EmitterBank();
+	EmitterBank(const EmitterBank&) = delete;
+	EmitterBank& operator=(const EmitterBank&) = delete;
+
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const;
+	const std::string& GetFilename() const;
+	size_t GetCount() const;
+	std::string_view GetName(size_t index) const;
+
+	// Returns the binary record of the emitter or nullptr if not found
+	const unsigned char* Find(std::string_view name, size_t* record_size) const;
+	const unsigned char* GetRecord(size_t index, size_t* record_size) const;
+
+	static uint64_t Hash(std::string_view name);
+
+private:
+	bool Validate();
+
+	std::string filename;
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	size_t count = 0;
+	size_t slotCount = 0;
+	const unsigned char* entries = nullptr;
+	const unsigned char* slots = nullptr;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "PropertyBindings.h"
+
+// Editor data saved alongside an emitter that Difu's ParticleEmitter has no field for
+struct EmitterExtras
+{
+	PropertyBindings bindings;
+	// Seconds simulated right after loading so the effect starts fully developed
+	float prewarm = 0.0f;
+};
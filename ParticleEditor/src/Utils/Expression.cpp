@@ -0,0 +1,429 @@
+#include "Expression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fmt/core.h>
+
+struct Expression::Compiler
+{
+	std::string_view text;
+	size_t pos = 0;
+	Instruction* code = nullptr;
+	int count = 0;
+	int depth = 0;
+	int nesting = 0;
+	std::string error;
+
+	bool Fail(const std::string& message)
+	{
+		if (error.empty())
+			error = fmt::format("column {}: {}", pos + 1, message);
+		return false;
+	}
+
+	bool Emit(OpCode op, float value = 0.0f)
+	{
+		int arguments = GetArgumentCount(op);
+
+		// The last n instructions being constants means they are exactly the n
+		// operands, so the whole subexpression collapses into one constant
+		if (op != OpCode::Constant && op != OpCode::Time && arguments <= count)
+		{
+			bool constant = true;
+			for (int i = count - arguments; i < count; i++)
+				constant = constant && code[i].op == OpCode::Constant;
+
+			if (constant)
+			{
+				float values[3];
+				for (int i = 0; i < arguments; i++)
+					values[i] = code[count - arguments + i].value;
+
+				count -= arguments;
+				depth -= arguments;
+				value = Execute(op, values);
+				op = OpCode::Constant;
+				arguments = 0;
+			}
+		}
+
+		// "x * 2" becomes MultiplyConstant(2) instead of pushing the 2
+		if (count > 0 && code[count - 1].op == OpCode::Constant)
+		{
+			OpCode fused = op;
+			switch (op)
+			{
+			case OpCode::Add:      fused = OpCode::AddConstant; break;
+			case OpCode::Subtract: fused = OpCode::SubtractConstant; break;
+			case OpCode::Multiply: fused = OpCode::MultiplyConstant; break;
+			case OpCode::Divide:   fused = OpCode::DivideConstant; break;
+			default: break;
+			}
+
+			if (fused != op)
+			{
+				code[count - 1] = {fused, code[count - 1].value};
+				depth--;
+				return true;
+			}
+		}
+
+		if (count >= MAX_INSTRUCTIONS)
+			return Fail("expression is too long");
+
+		code[count++] = {op, value};
+		depth += 1 - arguments;
+		if (depth > MAX_STACK)
+			return Fail("expression is nested too deeply");
+
+		return true;
+	}
+
+	// Paired with nesting-- once the nested part is parsed
+	bool Nest()
+	{
+		if (++nesting > MAX_NESTING)
+			return Fail("expression is nested too deeply");
+		return true;
+	}
+
+	void SkipSpaces()
+	{
+		while (pos < text.size() && std::isspace((unsigned char)text[pos]))
+			pos++;
+	}
+
+	bool Match(char ch)
+	{
+		SkipSpaces();
+		if (pos < text.size() && text[pos] == ch)
+		{
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	bool ParseExpression()
+	{
+		if (!ParseTerm())
+			return false;
+
+		while (true)
+		{
+			if (Match('+'))
+			{
+				if (!ParseTerm() || !Emit(OpCode::Add))
+					return false;
+			}
+			else if (Match('-'))
+			{
+				if (!ParseTerm() || !Emit(OpCode::Subtract))
+					return false;
+			}
+			else
+				return true;
+		}
+	}
+
+	bool ParseTerm()
+	{
+		if (!ParseUnary())
+			return false;
+
+		while (true)
+		{
+			OpCode op;
+			if (Match('*'))
+				op = OpCode::Multiply;
+			else if (Match('/'))
+				op = OpCode::Divide;
+			else if (Match('%'))
+				op = OpCode::Modulo;
+			else
+				return true;
+
+			if (!ParseUnary() || !Emit(op))
+				return false;
+		}
+	}
+
+	bool ParseUnary()
+	{
+		if (!Nest())
+			return false;
+
+		bool ok;
+		if (Match('-'))
+			ok = ParseUnary() && Emit(OpCode::Negate);
+		else if (Match('+'))
+			ok = ParseUnary();
+		else
+			ok = ParsePower();
+		nesting--;
+		return ok;
+	}
+
+	bool ParsePower()
+	{
+		if (!ParsePrimary())
+			return false;
+
+		// Right associative: 2^3^2 = 2^(3^2)
+		if (Match('^'))
+			return ParseUnary() && Emit(OpCode::Power);
+
+		return true;
+	}
+
+	bool ParseFunction(std::string_view name)
+	{
+		struct Function
+		{
+			std::string_view name;
+			OpCode op;
+		};
+		static const Function functions[] = {
+			{"sin", OpCode::Sin}, {"cos", OpCode::Cos}, {"tan", OpCode::Tan}, {"abs", OpCode::Abs},
+			{"sqrt", OpCode::Sqrt}, {"floor", OpCode::Floor}, {"fract", OpCode::Fract}, {"exp", OpCode::Exp},
+			{"log", OpCode::Log}, {"min", OpCode::Min}, {"max", OpCode::Max}, {"pow", OpCode::Power},
+			{"mod", OpCode::Modulo}, {"step", OpCode::Step}, {"clamp", OpCode::Clamp}, {"lerp", OpCode::Lerp}
+		};
+
+		for (const Function& function : functions)
+		{
+			if (function.name != name)
+				continue;
+
+			if (!Nest())
+				return false;
+			int arguments = GetArgumentCount(function.op);
+			for (int i = 0; i < arguments; i++)
+			{
+				if (i > 0 && !Match(','))
+					return Fail(fmt::format("{} takes {} arguments", name, arguments));
+				if (!ParseExpression())
+					return false;
+			}
+			nesting--;
+			if (!Match(')'))
+				return Fail(fmt::format("expected ')' after the arguments of {}", name));
+
+			return Emit(function.op);
+		}
+
+		return Fail(fmt::format("unknown function '{}'", name));
+	}
+
+	bool ParsePrimary()
+	{
+		SkipSpaces();
+		if (pos >= text.size())
+			return Fail("unexpected end of expression");
+
+		if (Match('('))
+		{
+			if (!Nest() || !ParseExpression())
+				return false;
+			nesting--;
+			if (!Match(')'))
+				return Fail("expected ')'");
+			return true;
+		}
+
+		char ch = text[pos];
+		if (std::isdigit((unsigned char)ch) || ch == '.')
+		{
+			float value;
+			std::from_chars_result result = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+			if (result.ec != std::errc())
+				return Fail("malformed number");
+			pos = result.ptr - text.data();
+			return Emit(OpCode::Constant, value);
+		}
+
+		if (std::isalpha((unsigned char)ch))
+		{
+			size_t start = pos;
+			while (pos < text.size() && (std::isalnum((unsigned char)text[pos]) || text[pos] == '_'))
+				pos++;
+			std::string_view name = text.substr(start, pos - start);
+
+			if (Match('('))
+				return ParseFunction(name);
+			if (name == "t")
+				return Emit(OpCode::Time);
+			if (name == "pi")
+				return Emit(OpCode::Constant, 3.14159265358979f);
+			if (name == "e")
+				return Emit(OpCode::Constant, 2.71828182845905f);
+
+			pos = start;
+			return Fail(fmt::format("unknown variable '{}'", name));
+		}
+
+		return Fail(fmt::format("unexpected '{}'", ch));
+	}
+};
+
+Expression::Expression()
+{
+}
+
+bool Expression::Compile(std::string_view _source, std::string* error)
+{
+	if (_source.size() > MAX_SOURCE_LENGTH)
+	{
+		if (error)
+			*error = fmt::format("expression is {} characters, at most {} are allowed", _source.size(), MAX_SOURCE_LENGTH);
+		return false;
+	}
+
+	// Compiled aside so a failed edit keeps the previous expression
+	Instruction compiled[MAX_INSTRUCTIONS];
+	Compiler compiler;
+	compiler.text = _source;
+	compiler.code = compiled;
+
+	bool ok = compiler.ParseExpression();
+	compiler.SkipSpaces();
+	if (ok && compiler.pos < _source.size())
+		ok = compiler.Fail(fmt::format("unexpected '{}'", _source[compiler.pos]));
+
+	if (!ok)
+	{
+		if (error)
+			*error = compiler.error;
+		return false;
+	}
+
+	std::copy(compiled, compiled + compiler.count, code);
+	count = compiler.count;
+	source = _source;
+	return true;
+}
+
+void Expression::Clear()
+{
+	count = 0;
+	source.clear();
+}
+
+int Expression::GetArgumentCount(OpCode op)
+{
+	switch (op)
+	{
+	case OpCode::Constant:
+	case OpCode::Time:
+		return 0;
+	case OpCode::Negate:
+	case OpCode::AddConstant:
+	case OpCode::SubtractConstant:
+	case OpCode::MultiplyConstant:
+	case OpCode::DivideConstant:
+	case OpCode::Sin:
+	case OpCode::Cos:
+	case OpCode::Tan:
+	case OpCode::Abs:
+	case OpCode::Sqrt:
+	case OpCode::Floor:
+	case OpCode::Fract:
+	case OpCode::Exp:
+	case OpCode::Log:
+		return 1;
+	case OpCode::Clamp:
+	case OpCode::Lerp:
+		return 3;
+	default:
+		return 2;
+	}
+}
+
+float Expression::Execute(OpCode op, const float* a)
+{
+	switch (op)
+	{
+	case OpCode::Add:      return a[0] + a[1];
+	case OpCode::Subtract: return a[0] - a[1];
+	case OpCode::Multiply: return a[0] * a[1];
+	case OpCode::Divide:   return a[0] / a[1];
+	case OpCode::Modulo:   return std::fmod(a[0], a[1]);
+	case OpCode::Power:    return std::pow(a[0], a[1]);
+	case OpCode::Negate:   return -a[0];
+	case OpCode::Sin:      return std::sin(a[0]);
+	case OpCode::Cos:      return std::cos(a[0]);
+	case OpCode::Tan:      return std::tan(a[0]);
+	case OpCode::Abs:      return std::fabs(a[0]);
+	case OpCode::Sqrt:     return std::sqrt(a[0]);
+	case OpCode::Floor:    return std::floor(a[0]);
+	case OpCode::Fract:    return a[0] - std::floor(a[0]);
+	case OpCode::Exp:      return std::exp(a[0]);
+	case OpCode::Log:      return std::log(a[0]);
+	case OpCode::Min:      return a[0] < a[1] ? a[0] : a[1];
+	case OpCode::Max:      return a[0] > a[1] ? a[0] : a[1];
+	case OpCode::Step:     return a[1] >= a[0] ? 1.0f : 0.0f;
+	case OpCode::Clamp:    return a[0] < a[1] ? a[1] : (a[0] > a[2] ? a[2] : a[0]);
+	case OpCode::Lerp:     return a[0] + (a[1] - a[0]) * a[2];
+	default:               return 0.0f;
+	}
+}
+
+float Expression::Evaluate(float t) const
+{
+	float stack[MAX_STACK];
+	float* top = stack;
+
+	// Operands are popped in place: top[-1] is the last pushed value
+	for (int i = 0; i < count; i++)
+	{
+		const Instruction& instruction = code[i];
+		switch (instruction.op)
+		{
+		case OpCode::Constant: *top++ = instruction.value; break;
+		case OpCode::Time:     *top++ = t; break;
+		case OpCode::Add:      top--; top[-1] = top[-1] + top[0]; break;
+		case OpCode::Subtract: top--; top[-1] = top[-1] - top[0]; break;
+		case OpCode::Multiply: top--; top[-1] = top[-1] * top[0]; break;
+		case OpCode::Divide:   top--; top[-1] = top[-1] / top[0]; break;
+		case OpCode::Negate:   top[-1] = -top[-1]; break;
+		case OpCode::AddConstant:      top[-1] = top[-1] + instruction.value; break;
+		case OpCode::SubtractConstant: top[-1] = top[-1] - instruction.value; break;
+		case OpCode::MultiplyConstant: top[-1] = top[-1] * instruction.value; break;
+		case OpCode::DivideConstant:   top[-1] = top[-1] / instruction.value; break;
+		case OpCode::Sin:      top[-1] = std::sin(top[-1]); break;
+		case OpCode::Cos:      top[-1] = std::cos(top[-1]); break;
+		default:
+		{
+			int arguments = GetArgumentCount(instruction.op);
+			top -= arguments;
+			*top = Execute(instruction.op, top);
+			top++;
+			break;
+		}
+		}
+	}
+
+	return count > 0 ? stack[0] : 0.0f;
+}
+
+bool Expression::IsEmpty() const
+{
+	return count == 0;
+}
+
+bool Expression::IsConstant() const
+{
+	return count == 1 && code[0].op == OpCode::Constant;
+}
+
+int Expression::GetInstructionCount() const
+{
+	return count;
+}
+
+const std::string& Expression::GetSource() const
+{
+	return source;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Small arithmetic language over the time variable t, e.g. "sin(t * 2) * 200 + 50".
+// Compile() turns the source into stack bytecode with constant subexpressions
+// folded and constant right operands fused into the operator, Evaluate() runs
+// it without allocating.
+//
+// Operators: + - * / % ^ and unary -, parentheses
+// Constants: pi, e
+// Functions: sin cos tan abs sqrt floor fract exp log (1 argument)
+//            min max pow mod step (2 arguments), clamp lerp (3 arguments)
+class Expression
+{
+public:
+	static constexpr int MAX_INSTRUCTIONS = 64;
+	static constexpr int MAX_STACK = 16;
+	// Longer sources are rejected before parsing, the binary emitter format stores at most this many
+	static constexpr size_t MAX_SOURCE_LENGTH = 255;
+	// Parser recursion bound, deeply nested input fails instead of overflowing the call stack
+	static constexpr int MAX_NESTING = 64;
+
+	Expression();
+
+	bool Compile(std::string_view source, std::string* error = nullptr);
+	void Clear();
+
+	float Evaluate(float t) const;
+
+	bool IsEmpty() const;
+	bool IsConstant() const;
+	int GetInstructionCount() const;
+	const std::string& GetSource() const;
+
+private:
+	enum class OpCode : unsigned char
+	{
+		Constant,
+		Time,
+		Add, Subtract, Multiply, Divide, Modulo, Power, Negate,
+		Sin, Cos, Tan, Abs, Sqrt, Floor, Fract, Exp, Log,
+		Min, Max, Step,
+		Clamp, Lerp,
+		// x op constant, emitted instead of Constant + the binary operator
+		AddConstant, SubtractConstant, MultiplyConstant, DivideConstant
+	};
+
+	struct Instruction
+	{
+		OpCode op;
+		float value;
+	};
+
+	struct Compiler;
+
+	static int GetArgumentCount(OpCode op);
+	static float Execute(OpCode op, const float* arguments);
+
+	Instruction code[MAX_INSTRUCTIONS];
+	int count = 0;
+	std::string source;
+};
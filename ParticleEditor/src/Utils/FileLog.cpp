@@ -0,0 +1,206 @@
+#include "FileLog.h"
+
+#include <Difu/Utils/Logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+
+FileLog::FileLog()
+{
+}
+
+FileLog::~FileLog()
+{
+	Close();
+}
+
+bool FileLog::Open(const std::string& _filename, size_t _maxFileSize, int _maxFiles)
+{
+	Close();
+
+	file = std::fopen(_filename.c_str(), "ab");
+	if (!file)
+	{
+		Logger::Error("Could not open log file {}: {}", _filename, std::strerror(errno));
+		return false;
+	}
+
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	fileSize = size > 0 ? size : 0;
+	filename = _filename;
+	maxFileSize = std::max<size_t>(_maxFileSize, BATCH_SIZE);
+	maxFiles = std::max(_maxFiles, 1);
+	batch.reserve(BATCH_SIZE + 256);
+	reportedDropped = dropped;
+	rotateFailed = false;
+	unwrittenBytes = 0;
+
+	running = true;
+	writer = std::thread(&FileLog::Run, this);
+	return true;
+}
+
+void FileLog::Close()
+{
+	if (!writer.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		running = false;
+	}
+	wake.notify_one();
+	writer.join();
+
+	if (file)
+		std::fclose(file);
+	file = nullptr;
+}
+
+bool FileLog::IsOpen() const
+{
+	return running;
+}
+
+void FileLog::Print(std::string value)
+{
+	if (!running || !pending.TryPush(std::move(value)))
+	{
+		dropped++;
+		return;
+	}
+
+	// Bursts wake the writer before the queue fills up, notify_one doesn't block
+	if (++pushed % (QUEUE_CAPACITY / 4) == 0)
+		wake.notify_one();
+}
+
+size_t FileLog::GetDroppedCount() const
+{
+	return dropped;
+}
+
+void FileLog::Run()
+{
+	std::string value;
+	bool stopping = false;
+	while (!stopping)
+	{
+		// Read before draining so nothing pushed before Close is left behind
+		stopping = !running;
+
+		while (pending.TryPop(&value))
+		{
+			batch += value;
+			batch += '\n';
+			if (batch.size() >= BATCH_SIZE)
+				Flush();
+		}
+
+		size_t droppedNow = dropped;
+		if (droppedNow != reportedDropped)
+		{
+			batch += fmt::format("[FileLog] {} messages dropped\n", droppedNow - reportedDropped);
+			reportedDropped = droppedNow;
+		}
+
+		if (!batch.empty())
+			Flush();
+
+		// Quiet periods are picked up every 50ms
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		if (running)
+			wake.wait_for(lock, std::chrono::milliseconds(50));
+	}
+}
+
+void FileLog::Flush()
+{
+	if (fileSize > 0 && fileSize + batch.size() > maxFileSize)
+		Rotate();
+
+	// Without a previous file to fall back to, try again on every flush
+	if (!file && Reopen(filename, "ab"))
+		rotateFailed = false;
+
+	if (file)
+	{
+		if (unwrittenBytes > 0)
+		{
+			std::string note = fmt::format("[FileLog] {} bytes lost while no log file could be opened\n", unwrittenBytes);
+			std::fwrite(note.data(), 1, note.size(), file);
+			fileSize += note.size();
+			unwrittenBytes = 0;
+		}
+		std::fwrite(batch.data(), 1, batch.size(), file);
+		std::fflush(file);
+		fileSize += batch.size();
+	}
+	else
+		unwrittenBytes += batch.size();
+	batch.clear();
+}
+
+void FileLog::Rotate()
+{
+	if (file)
+		std::fclose(file);
+	file = nullptr;
+
+	// After a failed attempt only the steps that didn't happen are redone
+	std::error_code error;
+	bool moveCurrent = !rotateFailed || std::filesystem::exists(filename, error);
+	bool moveOlder = !rotateFailed || std::filesystem::exists(GetRotatedName(1), error);
+	if (moveCurrent && moveOlder)
+	{
+		std::filesystem::remove(GetRotatedName(maxFiles - 1), error);
+		for (int i = maxFiles - 1; i > 0; i--)
+			std::filesystem::rename(GetRotatedName(i - 1), GetRotatedName(i), error);
+	}
+	else if (moveCurrent && maxFiles > 1)
+		std::filesystem::rename(filename, GetRotatedName(1), error);
+
+	// With a single file, "w" simply truncates it. Otherwise it must not truncate a file that wasn't moved.
+	bool moved = maxFiles == 1 || !std::filesystem::exists(filename, error);
+	if (moved && Reopen(filename, "wb"))
+	{
+		if (rotateFailed)
+			LOG_INFO("Log file {} is being written again", filename);
+		rotateFailed = false;
+		return;
+	}
+
+	if (!rotateFailed)
+		Logger::Error("Could not start a new log file {}, appending to the previous one", filename);
+	rotateFailed = true;
+
+	// fileSize stays over the limit, so the next batch tries again
+	Reopen(maxFiles > 1 && moved ? GetRotatedName(1) : filename, "ab");
+}
+
+bool FileLog::Reopen(const std::string& name, const char* mode)
+{
+	file = std::fopen(name.c_str(), mode);
+	if (!file)
+		return false;
+
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	fileSize = size > 0 ? size : 0;
+	return true;
+}
+
+std::string FileLog::GetRotatedName(int index) const
+{
+	if (index == 0)
+		return filename;
+
+	std::filesystem::path path(filename);
+	std::filesystem::path rotated = path.parent_path() / path.stem();
+	return fmt::format("{}.{}{}", rotated.string(), index, path.extension().string());
+}
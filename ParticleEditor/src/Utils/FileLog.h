@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "MpscQueue.h"
+
+// Appends every printed line to a log file from a background thread.
+// Print only pushes into a bounded queue, the writer thread batches lines and
+// rotates the file once it grows past maxFileSize: name.log -> name.1.log -> ...
+// If the new file can't be created, that is reported once and batches go to
+// the previous file until a later rotation succeeds.
+class FileLog
+{
+public:
+	static constexpr size_t QUEUE_CAPACITY = 4096;
+	static constexpr size_t BATCH_SIZE = 64 * 1024;
+	static constexpr size_t DEFAULT_MAX_FILE_SIZE = 1024 * 1024;
+	static constexpr int DEFAULT_MAX_FILES = 3;
+
+	FileLog();
+	~FileLog();
+
+	bool Open(const std::string& filename, size_t maxFileSize = DEFAULT_MAX_FILE_SIZE, int maxFiles = DEFAULT_MAX_FILES);
+	// Writes everything still queued before returning
+	void Close();
+	bool IsOpen() const;
+
+	// Safe to call from any thread, never blocks or touches the disk
+	void Print(std::string value);
+
+	// Messages lost because the queue was full
+	size_t GetDroppedCount() const;
+
+private:
+	void Run();
+	void Flush();
+	void Rotate();
+	bool Reopen(const std::string& name, const char* mode);
+	std::string GetRotatedName(int index) const;
+
+	MpscQueue<std::string> pending{QUEUE_CAPACITY};
+	std::atomic<size_t> dropped = 0;
+	std::atomic<size_t> pushed = 0;
+	std::atomic<bool> running = false;
+
+	// Wakes the writer early on bursts and on Close
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	std::thread writer;
+
+	// Owned by the writer thread while running
+	std::FILE* file = nullptr;
+	std::string filename;
+	std::string batch;
+	size_t fileSize = 0;
+	size_t maxFileSize = DEFAULT_MAX_FILE_SIZE;
+	int maxFiles = DEFAULT_MAX_FILES;
+	size_t reportedDropped = 0;
+	// Set once the failure to create a new file has been reported
+	bool rotateFailed = false;
+	size_t unwrittenBytes = 0;
+};
@@ -0,0 +1,176 @@
+#include "FlipbookBaker.h"
+#include "JobSystem.h"
+#include "SoftwareRasterizer.h"
+#include "Trace.h"
+#include "Simulation/FixedTimestep.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <Difu/Utils/Logger.h>
+
+namespace FlipbookBaker
+{
+	int Flipbook::GetAtlasWidth() const
+	{
+		return columns * frameWidth;
+	}
+
+	int Flipbook::GetAtlasHeight() const
+	{
+		return rows * frameHeight;
+	}
+
+	size_t Flipbook::GetAtlasMemory() const
+	{
+		return atlas.size() * sizeof(Color);
+	}
+
+	Rectangle Flipbook::GetFrameRect(int frame) const
+	{
+		return {(float)(frame % columns * frameWidth), (float)(frame / columns * frameHeight), (float)frameWidth, (float)frameHeight};
+	}
+
+	bool Bake(ParticleEmitter emitter, const EmitterExtras& extras, const Options& options, JobSystem* jobs, Flipbook* flipbook)
+	{
+		TRACE_SCOPE("FlipbookBaker::Bake");
+
+		if (options.frameCount <= 0 || options.frameWidth <= 0 || options.frameHeight <= 0)
+		{
+			Logger::Error("Can't bake {} frames of {}x{}", options.frameCount, options.frameWidth, options.frameHeight);
+			return false;
+		}
+
+		const float dt = FixedTimestep::DEFAULT_STEP;
+		Vector2 center = {options.frameWidth / 2.0f, options.frameHeight / 2.0f};
+		EmitterSettings settings = EmitterSettings::FromEmitter(emitter, center);
+		float lifetime = std::max(settings.lifetime, dt);
+		double period = options.period > 0.0f ? options.period : lifetime;
+		int frameCount = options.frameCount;
+
+		// Particles spawned late in the period are still alive up to a lifetime after it ends,
+		// those later passes wrap around onto the start of the loop
+		int passes = (int)std::ceil(lifetime / period) + 1;
+
+		std::vector<std::vector<ParticleInstance>> frames(frameCount);
+		std::vector<ParticleInstance> instances(ParticlePool::BLOCK_SIZE);
+		ParticleSystem system;
+		system.Reset(options.seed);
+		flipbook->peakParticles = 0;
+		flipbook->peakParticleMemory = 0;
+		size_t steps = 0;
+		std::chrono::steady_clock::duration stepTime = {};
+
+		for (int pass = 0; pass < passes; pass++)
+		{
+			for (int frame = 0; frame < frameCount; frame++)
+			{
+				double target = (pass + (double)frame / frameCount) * period;
+				while (system.GetTime() < target)
+				{
+					extras.bindings.Apply(&emitter, (float)system.GetTime());
+					settings = EmitterSettings::FromEmitter(emitter, center);
+
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					system.Step(settings, dt);
+					stepTime += std::chrono::steady_clock::now() - start;
+					steps++;
+
+					flipbook->peakParticles = std::max(flipbook->peakParticles, system.GetCount());
+					flipbook->peakParticleMemory = std::max(flipbook->peakParticleMemory, system.GetBlockCount() * ParticlePool::BLOCK_SIZE * sizeof(SimParticle));
+				}
+
+				// Between the last two steps, like the editor draws between fixed steps
+				float alpha = 1.0f - (float)((system.GetTime() - target) / dt);
+				for (size_t b = 0; b < system.GetBlockCount(); b++)
+				{
+					size_t count = system.GetInstances(b, settings, alpha, instances.data());
+					// The system has its own pool, which keeps the default ArrayOfStructs layout
+					const SimParticle* particles = system.GetBlock(b, &count);
+					for (size_t i = 0; i < count; i++)
+					{
+						float age = particles[i].age - (1.0f - alpha) * dt;
+						double spawnTime = target - age;
+						if (age >= 0.0f && spawnTime >= 0.0 && spawnTime < period)
+							frames[frame].push_back(instances[i]);
+					}
+				}
+			}
+		}
+		flipbook->stepMicroseconds = steps > 0 ? std::chrono::duration<double, std::micro>(stepTime).count() / steps : 0.0;
+
+		flipbook->frameWidth = options.frameWidth;
+		flipbook->frameHeight = options.frameHeight;
+		flipbook->frameCount = frameCount;
+		flipbook->columns = (int)std::ceil(std::sqrt((double)frameCount));
+		flipbook->rows = (frameCount + flipbook->columns - 1) / flipbook->columns;
+		flipbook->period = (float)period;
+		flipbook->atlas.assign((size_t)flipbook->GetAtlasWidth() * flipbook->GetAtlasHeight(), BLANK);
+
+		// Every frame is independent, so each job rasterizes whole frames on its own
+		auto render = [&](size_t begin, size_t end)
+		{
+			SoftwareRasterizer rasterizer;
+			rasterizer.Resize(options.frameWidth, options.frameHeight);
+			for (size_t frame = begin; frame < end; frame++)
+			{
+				rasterizer.Begin(BLANK, true);
+				rasterizer.Add(frames[frame].data(), frames[frame].size());
+				rasterizer.End();
+
+				Rectangle rect = flipbook->GetFrameRect((int)frame);
+				for (int y = 0; y < options.frameHeight; y++)
+				{
+					const Color* source = rasterizer.GetPixels() + (size_t)y * options.frameWidth;
+					Color* destination = &flipbook->atlas[((size_t)rect.y + y) * flipbook->GetAtlasWidth() + (size_t)rect.x];
+					std::copy(source, source + options.frameWidth, destination);
+				}
+			}
+		};
+		if (jobs)
+			jobs->ParallelFor(frameCount, 1, render);
+		else
+			render(0, frameCount);
+
+		return true;
+	}
+
+	bool Save(const std::string& filename, const Flipbook& flipbook)
+	{
+		TRACE_SCOPE("FlipbookBaker::Save");
+
+		Image image = {(void*)flipbook.atlas.data(), flipbook.GetAtlasWidth(), flipbook.GetAtlasHeight(), 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+		if (!ExportImage(image, filename.c_str()))
+		{
+			Logger::Error("Couldn't write atlas {}", filename);
+			return false;
+		}
+
+		std::filesystem::path metadataFilename = filename;
+		metadataFilename.replace_extension(".pflip");
+		std::ofstream out(metadataFilename);
+		if (!out)
+		{
+			Logger::Error("Couldn't open file {}: {}", metadataFilename.string(), std::strerror(errno));
+			return false;
+		}
+
+		out << "FLIPBOOK\n{\n";
+		out << "\tATLAS : " << std::filesystem::path(filename).filename().string() << ";\n";
+		out << "\tFRAME_SIZE : { " << flipbook.frameWidth << ", " << flipbook.frameHeight << " };\n";
+		out << "\tGRID : { " << flipbook.columns << ", " << flipbook.rows << " };\n";
+		out << "\tFRAME_COUNT : " << flipbook.frameCount << ";\n";
+		out << "\tPERIOD : " << flipbook.period << ";\n";
+		out << "\tPREMULTIPLIED_ALPHA : 1;\n";
+		out << "}\n";
+		out.close();
+
+		LOG_INFO("Saved {} frame flipbook to {}", flipbook.frameCount, filename);
+		return true;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "EmitterExtras.h"
+#include "Simulation/ParticleSystem.h"
+
+#include <Difu/Particles/ParticleEmitter.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Pre-renders an emitter into a looping sprite sheet. The fixed timestep
+// simulation is run once and frame i of the loop shows every particle spawned
+// during the first period, each at the age it has i / frameCount periods
+// later, wrapped around the period. The last frame flows into the first
+// without a jump. Frames are rasterized in parallel on the CPU.
+// Time bindings are evaluated as usual, so they only loop if they repeat
+// with the period.
+namespace FlipbookBaker
+{
+	struct Options
+	{
+		int frameWidth = 256;
+		int frameHeight = 256;
+		int frameCount = 32;
+		// Length of the loop in seconds, 0 uses the particle lifetime
+		float period = 0.0f;
+		uint64_t seed = 1;
+	};
+
+	struct Flipbook
+	{
+		int frameWidth = 0;
+		int frameHeight = 0;
+		int frameCount = 0;
+		int columns = 0;
+		int rows = 0;
+		float period = 0.0f;
+		// Premultiplied RGBA, frames left to right then top to bottom
+		std::vector<Color> atlas;
+
+		// Cost of running the emitter live instead, measured while baking
+		size_t peakParticles = 0;
+		size_t peakParticleMemory = 0;
+		double stepMicroseconds = 0.0;
+
+		int GetAtlasWidth() const;
+		int GetAtlasHeight() const;
+		size_t GetAtlasMemory() const;
+		Rectangle GetFrameRect(int frame) const;
+	};
+
+	// The emitter is centered in every frame
+	bool Bake(ParticleEmitter emitter, const EmitterExtras& extras, const Options& options, JobSystem* jobs, Flipbook* flipbook);
+	// Writes the atlas as a PNG and the layout next to it, with the extension replaced by .pflip
+	bool Save(const std::string& filename, const Flipbook& flipbook);
+}
@@ -0,0 +1,125 @@
+#include "IdleThrottle.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOGDI
+	#define NOUSER
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+#include <raylib.h>
+
+IdleThrottle::State IdleThrottle::Update(float dt, bool animating)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	float wall = std::chrono::duration<float>(now - sampleStart).count();
+	if (wall >= 1.0f)
+	{
+		double cpuSeconds = GetProcessCpuSeconds();
+		cpuUsage = (float)((cpuSeconds - sampleCpuSeconds) / wall);
+		sampleCpuSeconds = cpuSeconds;
+		sampleStart = now;
+	}
+
+	State previous = state;
+	if (!enabled)
+		state = State::Active;
+	else if (IsWindowMinimized() || IsWindowHidden())
+		state = State::Hidden;
+	else
+	{
+		// Checked while unfocused too, hovering still updates ImGui
+		if (animating || HasInput())
+			quietTime = 0.0f;
+		else
+			quietTime += dt;
+
+		if (quietTime >= IDLE_DELAY)
+			state = State::Idle;
+		else if (!IsWindowFocused() && animating)
+			state = State::Background;
+		else
+			state = State::Active;
+	}
+
+	if (state != previous)
+		SetTargetFPS(GetTargetFPS());
+	return state;
+}
+
+double IdleThrottle::GetProcessCpuSeconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	// 100 ns ticks
+	ULARGE_INTEGER kernelTicks = {{kernel.dwLowDateTime, kernel.dwHighDateTime}};
+	ULARGE_INTEGER userTicks = {{user.dwLowDateTime, user.dwHighDateTime}};
+	return (kernelTicks.QuadPart + userTicks.QuadPart) * 1e-7;
+#else
+	timespec time;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+		return 0.0;
+	return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+}
+
+bool IdleThrottle::HasInput()
+{
+	Vector2 mouseDelta = GetMouseDelta();
+	if (mouseDelta.x != 0.0f || mouseDelta.y != 0.0f || GetMouseWheelMove() != 0.0f || IsWindowResized())
+		return true;
+
+	for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++)
+	{
+		if (IsMouseButtonDown(button))
+			return true;
+	}
+
+	// The key and char queues belong to ImGui, so look at held keys instead of popping them
+	for (int key = KEY_SPACE; key <= KEY_KB_MENU; key++)
+	{
+		if (IsKeyDown(key))
+			return true;
+	}
+	return false;
+}
+
+void IdleThrottle::SetEnabled(bool _enabled)
+{
+	enabled = _enabled;
+	quietTime = 0.0f;
+}
+
+bool IdleThrottle::IsEnabled() const
+{
+	return enabled;
+}
+
+IdleThrottle::State IdleThrottle::GetState() const
+{
+	return state;
+}
+
+int IdleThrottle::GetTargetFPS() const
+{
+	switch (state)
+	{
+	case State::Background:
+		return BACKGROUND_FPS;
+	case State::Idle:
+		return IDLE_FPS;
+	case State::Hidden:
+		return HIDDEN_FPS;
+	default:
+		return ACTIVE_FPS;
+	}
+}
+
+float IdleThrottle::GetCpuUsage() const
+{
+	return cpuUsage;
+}
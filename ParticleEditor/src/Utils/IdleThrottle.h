@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+
+// Lowers the frame rate while nothing on screen changes. Any input, or the
+// caller reporting an animation, brings back ACTIVE_FPS at once. raylib 4.0
+// can't block on input events, so idle frames still poll input, just a few
+// times a second, and the rest of the time is spent sleeping in EndDrawing.
+class IdleThrottle
+{
+public:
+	enum class State
+	{
+		Active,
+		// Animating while another window has focus
+		Background,
+		Idle,
+		// Minimized or hidden
+		Hidden
+	};
+
+	static constexpr int ACTIVE_FPS = 60;
+	static constexpr int BACKGROUND_FPS = 30;
+	// A default fixed timestep still fits in FixedTimestep's 4 substeps
+	static constexpr int IDLE_FPS = 15;
+	static constexpr int HIDDEN_FPS = 5;
+	// Seconds without input or animation before going idle
+	static constexpr float IDLE_DELAY = 0.5f;
+
+	// Call once per frame before anything reads input, sets the target FPS when the state changes
+	State Update(float dt, bool animating);
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled() const;
+	State GetState() const;
+	int GetTargetFPS() const;
+	// Process CPU time over wall time for the last second, 1 is one core busy
+	float GetCpuUsage() const;
+
+	// CPU time used by every thread of the process so far. std::clock is wall time on Windows.
+	static double GetProcessCpuSeconds();
+
+private:
+	static bool HasInput();
+
+	bool enabled = true;
+	State state = State::Active;
+	float quietTime = 0.0f;
+
+	std::chrono::steady_clock::time_point sampleStart = std::chrono::steady_clock::now();
+	double sampleCpuSeconds = GetProcessCpuSeconds();
+	float cpuUsage = 0.0f;
+};
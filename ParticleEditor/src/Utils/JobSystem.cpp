@@ -0,0 +1,169 @@
+#include "JobSystem.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <string>
+
+// Which queue the current thread owns, threads outside any pool use 0
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local size_t currentQueue = 0;
+
+JobSystem::JobSystem()
+{
+	queues.push_back(std::make_unique<Queue>());
+}
+
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+void JobSystem::Start(unsigned workerCount)
+{
+	Stop();
+
+	running = true;
+	for (unsigned i = 0; i < workerCount; i++)
+		queues.push_back(std::make_unique<Queue>());
+	for (unsigned i = 0; i < workerCount; i++)
+		workers.emplace_back(&JobSystem::WorkerLoop, this, (size_t)i + 1);
+}
+
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+	queues.resize(1);
+}
+
+unsigned JobSystem::GetWorkerCount() const
+{
+	return (unsigned)workers.size();
+}
+
+unsigned JobSystem::GetDefaultWorkerCount()
+{
+	unsigned hardware = std::thread::hardware_concurrency();
+	return hardware > 1 ? hardware - 1 : 0;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, Function function, void* context)
+{
+	grain = std::max<size_t>(grain, 1);
+	if (workers.empty() || count <= grain)
+	{
+		if (count > 0)
+			function(context, 0, count);
+		return;
+	}
+
+	size_t self = GetQueueIndex();
+	size_t chunks = (count + grain - 1) / grain;
+	std::atomic<size_t> pending = chunks - 1;
+
+	// Pushed last to first, so this thread pops them back in order while others steal from the end
+	for (size_t chunk = chunks; chunk-- > 1;)
+	{
+		Job job = {function, context, chunk * grain, std::min(count, (chunk + 1) * grain), &pending};
+		if (!Push(self, job))
+		{
+			function(context, job.begin, job.end);
+			pending.fetch_sub(1, std::memory_order_release);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wake.notify_all();
+
+	function(context, 0, grain);
+	while (pending.load(std::memory_order_acquire) > 0)
+	{
+		if (!RunOne(self))
+			std::this_thread::yield();
+	}
+}
+
+size_t JobSystem::GetQueueIndex() const
+{
+	return currentSystem == this ? currentQueue : 0;
+}
+
+bool JobSystem::Push(size_t index, const Job& job)
+{
+	Queue& queue = *queues[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.size == QUEUE_CAPACITY)
+		return false;
+
+	queue.jobs[(queue.front + queue.size) % QUEUE_CAPACITY] = job;
+	queue.size++;
+	queued.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+bool JobSystem::Pop(size_t index, Job* job)
+{
+	Queue& queue = *queues[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.size == 0)
+		return false;
+
+	queue.size--;
+	*job = queue.jobs[(queue.front + queue.size) % QUEUE_CAPACITY];
+	queued.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool JobSystem::Steal(size_t index, Job* job)
+{
+	for (size_t i = 1; i < queues.size(); i++)
+	{
+		Queue& queue = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.size == 0)
+			continue;
+
+		*job = queue.jobs[queue.front];
+		queue.front = (queue.front + 1) % QUEUE_CAPACITY;
+		queue.size--;
+		queued.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::RunOne(size_t index)
+{
+	Job job;
+	if (!Pop(index, &job) && !Steal(index, &job))
+		return false;
+
+	TRACE_SCOPE("Job");
+	job.function(job.context, job.begin, job.end);
+	job.pending->fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+	currentSystem = this;
+	currentQueue = index;
+	Trace::SetThreadName(("Worker " + std::to_string(index)).c_str());
+
+	while (running.load(std::memory_order_acquire))
+	{
+		if (RunOne(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this] { return !running.load(std::memory_order_relaxed) || queued.load(std::memory_order_acquire) > 0; });
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool. Every worker has its own job queue and
+// threads outside the pool share one more. A thread runs the newest job of
+// its own queue first and steals the oldest job of another queue when its own
+// is empty. ParallelFor keeps running jobs while it waits for its own, so jobs
+// may start more jobs, and returning from it is a barrier for all of them.
+class JobSystem
+{
+public:
+	// Jobs beyond this per queue run right away on the thread that submits them
+	static constexpr size_t QUEUE_CAPACITY = 1024;
+
+	using Function = void (*)(void* context, size_t begin, size_t end);
+
+	JobSystem();
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// With 0 workers every job runs on the thread calling ParallelFor.
+	// Only call while no ParallelFor is running.
+	void Start(unsigned workerCount);
+	void Stop();
+	unsigned GetWorkerCount() const;
+	// One worker per hardware thread besides the calling one
+	static unsigned GetDefaultWorkerCount();
+
+	// Calls function with consecutive [begin, end) ranges of at most grain
+	// items covering [0, count), and returns once every call has finished
+	void ParallelFor(size_t count, size_t grain, Function function, void* context);
+
+	template<typename F>
+	void ParallelFor(size_t count, size_t grain, const F& function)
+	{
+		ParallelFor(count, grain, [](void* context, size_t begin, size_t end) { (*(const F*)context)(begin, end); }, (void*)&function);
+	}
+
+private:
+	struct Job
+	{
+		Function function;
+		void* context;
+		size_t begin;
+		size_t end;
+		std::atomic<size_t>* pending;
+	};
+
+	// Fixed size ring, the owner pushes and pops at the back and thieves take from the front
+	struct Queue
+	{
+		std::mutex mutex;
+		Job jobs[QUEUE_CAPACITY];
+		size_t front = 0;
+		size_t size = 0;
+	};
+
+	size_t GetQueueIndex() const;
+	bool Push(size_t queue, const Job& job);
+	bool Pop(size_t queue, Job* job);
+	bool Steal(size_t queue, Job* job);
+	// Runs one job from the given queue or stolen from another, false if there was none
+	bool RunOne(size_t queue);
+	void WorkerLoop(size_t queue);
+
+	// Index 0 is shared by threads outside the pool, worker i uses i + 1
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<bool> running = false;
+
+	// Workers sleep while nothing is queued anywhere
+	std::atomic<size_t> queued = 0;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free queue for many producer threads and one consumer thread.
+// Each cell carries a sequence number telling whether it is ready to be written
+// (sequence == position) or read (sequence == position + 1), so producers only
+// contend on one compare-exchange and never wait on each other or the consumer.
+template<typename T>
+class MpscQueue
+{
+public:
+	// Capacity is rounded up to a power of two
+	explicit MpscQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+
+		cells = std::make_unique<Cell[]>(size);
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	// Any thread. Returns false without blocking if the queue is full.
+	bool TryPush(T&& value)
+	{
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[position & mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.value = std::move(value);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Consumer thread only
+	bool TryPop(T* value)
+	{
+		Cell& cell = cells[dequeuePosition & mask];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if ((intptr_t)sequence - (intptr_t)(dequeuePosition + 1) < 0)
+			return false;
+
+		*value = std::move(cell.value);
+		cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+		dequeuePosition++;
+		return true;
+	}
+
+	size_t GetCapacity() const
+	{
+		return mask + 1;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask = 0;
+	alignas(64) std::atomic<size_t> enqueuePosition = 0;
+	alignas(64) size_t dequeuePosition = 0;
+};
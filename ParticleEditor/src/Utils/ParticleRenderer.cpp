@@ -0,0 +1,189 @@
+#include "ParticleRenderer.h"
+
+#include <Difu/Utils/Logger.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <raymath.h>
+#include <rlgl.h>
+
+// Two triangles of a unit quad around the particle's center
+static const float CORNERS[] = {
+	-0.5f, -0.5f,  -0.5f, 0.5f,  0.5f, 0.5f,
+	-0.5f, -0.5f,  0.5f, 0.5f,  0.5f, -0.5f
+};
+static constexpr int CORNER_COUNT = 6;
+
+// Same rotation as DrawRectanglePro with the origin at the center
+static const char* VERTEX_SHADER = R"(#version 330
+in vec2 corner;
+in vec4 rect;
+in float rotation;
+in vec4 color;
+uniform mat4 mvp;
+out vec4 fragColor;
+void main()
+{
+	float angle = radians(rotation);
+	vec2 offset = corner * rect.zw;
+	vec2 position = rect.xy + vec2(offset.x * cos(angle) - offset.y * sin(angle), offset.x * sin(angle) + offset.y * cos(angle));
+	gl_Position = mvp * vec4(position, 0.0, 1.0);
+	fragColor = color;
+}
+)";
+
+static const char* FRAGMENT_SHADER = R"(#version 330
+in vec4 fragColor;
+out vec4 finalColor;
+void main()
+{
+	finalColor = fragColor;
+}
+)";
+
+static constexpr size_t INITIAL_CAPACITY = 4096;
+
+bool ParticleRenderer::Load()
+{
+	int version = rlGetVersion();
+	if (version != OPENGL_33 && version != OPENGL_43)
+	{
+		LOG_WARN("Instanced particle rendering needs OpenGL 3.3, drawing particles one by one");
+		return false;
+	}
+
+	shader = rlLoadShaderCode(VERTEX_SHADER, FRAGMENT_SHADER);
+	if (shader == 0 || shader == rlGetShaderIdDefault())
+	{
+		LOG_ERROR("Failed to load the particle shader, drawing particles one by one");
+		shader = 0;
+		return false;
+	}
+	mvpLocation = rlGetLocationUniform(shader, "mvp");
+
+	vertexArray = rlLoadVertexArray();
+	if (vertexArray == 0)
+	{
+		LOG_ERROR("Vertex arrays are not supported, drawing particles one by one");
+		Unload();
+		return false;
+	}
+
+	rlEnableVertexArray(vertexArray);
+	int cornerLocation = rlGetLocationAttrib(shader, "corner");
+	cornerBuffer = rlLoadVertexBuffer((void*)CORNERS, sizeof(CORNERS), false);
+	rlSetVertexAttribute(cornerLocation, 2, RL_FLOAT, false, 0, 0);
+	rlEnableVertexAttribute(cornerLocation);
+	CreateInstanceBuffer(INITIAL_CAPACITY);
+	rlDisableVertexArray();
+	rlDisableVertexBuffer();
+
+	return true;
+}
+
+void ParticleRenderer::Unload()
+{
+	if (instanceBuffer)
+		rlUnloadVertexBuffer(instanceBuffer);
+	if (cornerBuffer)
+		rlUnloadVertexBuffer(cornerBuffer);
+	if (vertexArray)
+		rlUnloadVertexArray(vertexArray);
+	if (shader)
+		rlUnloadShaderProgram(shader);
+
+	instanceBuffer = 0;
+	cornerBuffer = 0;
+	vertexArray = 0;
+	shader = 0;
+	capacity = 0;
+}
+
+bool ParticleRenderer::IsSupported() const
+{
+	return vertexArray != 0;
+}
+
+// Expects the vertex array to be bound
+void ParticleRenderer::CreateInstanceBuffer(size_t _capacity)
+{
+	if (instanceBuffer)
+		rlUnloadVertexBuffer(instanceBuffer);
+
+	capacity = _capacity;
+	instanceBuffer = rlLoadVertexBuffer(nullptr, (int)(capacity * sizeof(ParticleInstance)), true);
+
+	int rectLocation = rlGetLocationAttrib(shader, "rect");
+	int rotationLocation = rlGetLocationAttrib(shader, "rotation");
+	int colorLocation = rlGetLocationAttrib(shader, "color");
+	int stride = sizeof(ParticleInstance);
+	rlSetVertexAttribute(rectLocation, 4, RL_FLOAT, false, stride, (void*)offsetof(ParticleInstance, x));
+	rlSetVertexAttribute(rotationLocation, 1, RL_FLOAT, false, stride, (void*)offsetof(ParticleInstance, rotation));
+	rlSetVertexAttribute(colorLocation, 4, RL_UNSIGNED_BYTE, true, stride, (void*)offsetof(ParticleInstance, color));
+	for (int location : {rectLocation, rotationLocation, colorLocation})
+	{
+		rlEnableVertexAttribute(location);
+		rlSetVertexAttributeDivisor(location, 1);
+	}
+}
+
+void ParticleRenderer::Begin()
+{
+	instances.clear();
+}
+
+void ParticleRenderer::Add(const ParticleSystem& system, const EmitterSettings& settings, float alpha)
+{
+	size_t offset = instances.size();
+	instances.resize(offset + system.GetBlockCount() * ParticlePool::BLOCK_SIZE);
+	for (size_t b = 0; b < system.GetBlockCount(); b++)
+		offset += system.GetInstances(b, settings, alpha, instances.data() + offset);
+	instances.resize(offset);
+}
+
+void ParticleRenderer::End()
+{
+	if (!IsSupported() || instances.empty())
+		return;
+
+	rlDrawRenderBatchActive();
+
+	rlEnableVertexArray(vertexArray);
+	if (instances.size() > capacity)
+		CreateInstanceBuffer(std::max(instances.size(), capacity * 2));
+	rlUpdateVertexBuffer(instanceBuffer, instances.data(), (int)(instances.size() * sizeof(ParticleInstance)), 0);
+
+	rlEnableShader(shader);
+	Matrix modelView = MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview());
+	rlSetUniformMatrix(mvpLocation, MatrixMultiply(modelView, rlGetMatrixProjection()));
+	rlDrawVertexArrayInstanced(0, CORNER_COUNT, (int)instances.size());
+	rlDisableShader();
+	rlDisableVertexArray();
+	rlDisableVertexBuffer();
+
+	drawCalls++;
+	vertices += instances.size() * CORNER_COUNT;
+	instanceCount += instances.size();
+}
+
+void ParticleRenderer::ResetStats()
+{
+	drawCalls = 0;
+	vertices = 0;
+	instanceCount = 0;
+}
+
+size_t ParticleRenderer::GetDrawCalls() const
+{
+	return drawCalls;
+}
+
+size_t ParticleRenderer::GetVertices() const
+{
+	return vertices;
+}
+
+size_t ParticleRenderer::GetInstances() const
+{
+	return instanceCount;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Simulation/ParticleSystem.h"
+
+#include <cstddef>
+#include <vector>
+
+// Draws whole particle systems with one instanced draw call. Every particle
+// added between Begin and End goes into one instance buffer that stays on the
+// GPU across frames, End uploads it and draws a quad per instance. Needs
+// OpenGL 3.3, IsSupported() is false otherwise and particles should be drawn
+// with ParticleSystem::Render instead.
+class ParticleRenderer
+{
+public:
+	// Needs a GL context, call after the window opens
+	bool Load();
+	void Unload();
+	bool IsSupported() const;
+
+	void Begin();
+	void Add(const ParticleSystem& system, const EmitterSettings& settings, float alpha);
+	// Flushes raylib's batch first, so the particles land on top of anything drawn before
+	void End();
+
+	// Counted since the last ResetStats
+	void ResetStats();
+	size_t GetDrawCalls() const;
+	size_t GetVertices() const;
+	size_t GetInstances() const;
+
+private:
+	void CreateInstanceBuffer(size_t capacity);
+
+	unsigned int shader = 0;
+	int mvpLocation = -1;
+	unsigned int vertexArray = 0;
+	unsigned int cornerBuffer = 0;
+	unsigned int instanceBuffer = 0;
+	// Instances the GPU buffer has room for, it only grows
+	size_t capacity = 0;
+	std::vector<ParticleInstance> instances;
+
+	size_t drawCalls = 0;
+	size_t vertices = 0;
+	size_t instanceCount = 0;
+};
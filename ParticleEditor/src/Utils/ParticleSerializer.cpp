@@ -1,27 +1,23 @@
 #include "ParticleSerializer.h"
+#include "Trace.h"
 
 #include <iostream>
 #include <fstream>
-#include <map>
-#include <sstream>
+#include <set>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <cerrno>
 
 #include <Difu/Utils/Logger.h>
+#include <fmt/core.h>
 
 namespace ParticleSerializer
 {
-	std::string trim(const std::string& str)
-	{
-		size_t first = str.find_first_not_of(" \t");
-		if (std::string::npos == first)
-		{
-			return str;
-		}
-		size_t last = str.find_last_not_of(" \t");
-		return str.substr(first, (last - first + 1));
-	}
-
 	static int ParseHexDigit(char hex)
 	{
 		if (hex > 47 && hex < 58)
@@ -34,22 +30,6 @@ namespace ParticleSerializer
 		return -1;
 	}
 	
-	static int ParseHexNumber(const std::string& hex)
-	{
-		int result = 0;
-	
-		for (char ch : hex)
-		{
-			int digit = ParseHexDigit(ch);
-			if (digit < 0)
-				return -1;
-			
-			result = result * 0x10 + digit;
-		}
-	
-		return result;
-	}
-
 	static std::string DecToHex(unsigned char value)
 	{
 		std::string result;
@@ -79,83 +59,386 @@ namespace ParticleSerializer
 		return  result;
 	}
 
-	static void OutFloat(std::ofstream& out, const std::string& name, float value)
+	static void OutFloat(std::ostream& out, const std::string& name, float value)
 	{
 		out << "\t" << name << " : float : " << value << ";\n";
 	}
 
-	static void OutVector2(std::ofstream& out, const std::string& name, Vector2 value)
+	static void OutVector2(std::ostream& out, const std::string& name, Vector2 value)
 	{
 		out << "\t" << name << " : vector2f : { " << value.x << ", " << value.y << " };\n";
 	}
 
-	static void OutColor(std::ofstream& out, const std::string& name, Color value)
+	static void OutColor(std::ostream& out, const std::string& name, Color value)
 	{
 		out << "\t" << name << " : color : #" << ColorToAARRGGBB(value) << ";\n";
 	}
 
-	// TODO: Error checking
-	float InGetFloat(std::map<std::string, std::string>& map, const std::string& value)
+	enum class FieldType : unsigned short
+	{
+		Float = 1,
+		Vector2 = 2,
+		Color = 3
+	};
+
+	// Ids are stored in binary files, only ever append
+	enum FieldId : unsigned short
+	{
+		FIELD_LIFETIME = 1,
+		FIELD_RESOLUTION,
+		FIELD_MIN_SIZE_FACTOR,
+		FIELD_MAX_SIZE_FACTOR,
+		FIELD_VELOCITY,
+		FIELD_ACCELERATION,
+		FIELD_CENTRIPETAL_ACCELERATION,
+		FIELD_ROTATION,
+		FIELD_ROTATION_VELOCITY,
+		FIELD_ROTATION_ACCELERATION,
+		FIELD_START_COLOR,
+		FIELD_END_COLOR,
+		FIELD_SPAWN_INTERVAL,
+		FIELD_RANDOMNESS,
+		FIELD_SPREAD,
+
+		FIELD_COUNT = FIELD_SPREAD
+	};
+
+	static const FieldType FIELD_TYPES[FIELD_COUNT] = {
+		FieldType::Float,   // LIFETIME
+		FieldType::Vector2, // RESOLUTION
+		FieldType::Float,   // MIN_SIZE_FACTOR
+		FieldType::Float,   // MAX_SIZE_FACTOR
+		FieldType::Vector2, // VELOCITY
+		FieldType::Vector2, // ACCELERATION
+		FieldType::Float,   // CENTRIPETAL_ACCELERATION
+		FieldType::Float,   // ROTATION
+		FieldType::Float,   // ROTATION_VELOCITY
+		FieldType::Float,   // ROTATION_ACCELERATION
+		FieldType::Color,   // START_COLOR
+		FieldType::Color,   // END_COLOR
+		FieldType::Float,   // SPAWN_INTERVAL
+		FieldType::Float,   // RANDOMNESS
+		FieldType::Float    // SPREAD
+	};
+
+	static const unsigned char BINARY_MAGIC[4] = {'P', 'E', 'M', 'B'};
+
+	static void WriteU16(unsigned char* out, unsigned short value)
+	{
+		out[0] = value & 0xFF;
+		out[1] = (value >> 8) & 0xFF;
+	}
+
+	static void WriteF32(unsigned char* out, float value)
 	{
-		std::string floatStr = map.at(value);
-		return std::stof(floatStr);
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		out[0] = bits & 0xFF;
+		out[1] = (bits >> 8) & 0xFF;
+		out[2] = (bits >> 16) & 0xFF;
+		out[3] = (bits >> 24) & 0xFF;
 	}
 
-	Vector2 InGetVector2(std::map<std::string, std::string>& map, const std::string& value)
+	static void WriteU32(unsigned char* out, uint32_t value)
 	{
-		std::string vector2Str = map.at(value);
-		vector2Str = trim(vector2Str.substr(1, vector2Str.size() - 2));
+		out[0] = value & 0xFF;
+		out[1] = (value >> 8) & 0xFF;
+		out[2] = (value >> 16) & 0xFF;
+		out[3] = (value >> 24) & 0xFF;
+	}
 
-		size_t comma = vector2Str.find(",");
-		std::string xStr = trim(vector2Str.substr(0, comma)); 
-		std::string yStr = trim(vector2Str.substr(comma + 1)); 
+	static unsigned short ReadU16(const unsigned char* in)
+	{
+		return (unsigned short)(in[0] | (in[1] << 8));
+	}
 
-		float x = std::stof(xStr);
-		float y = std::stof(yStr);
+	static float ReadF32(const unsigned char* in)
+	{
+		uint32_t bits = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
 
-		return {x, y};
+	static void WriteFloatField(unsigned char* out, float value)
+	{
+		WriteF32(out, value);
 	}
 
-	Color InGetColor(std::map<std::string, std::string>& map, const std::string& value)
+	static void WriteVector2Field(unsigned char* out, Vector2 value)
 	{
-		std::string hex = map.at(value);
+		WriteF32(out, value.x);
+		WriteF32(out + 4, value.y);
+	}
 
-		hex = hex.substr(1);
+	static void WriteColorField(unsigned char* out, Color value)
+	{
+		out[0] = value.r;
+		out[1] = value.g;
+		out[2] = value.b;
+		out[3] = value.a;
+	}
 
-		if (hex.size() != 8)
+	static void EncodeField(unsigned char* out, FieldId id, const ParticleEmitter& emitter)
+	{
+		WriteU16(out, id);
+		WriteU16(out + 2, (unsigned short)FIELD_TYPES[id - 1]);
+		unsigned char* payload = out + 4;
+		std::memset(payload, 0, 8);
+
+		switch (id)
 		{
-			Logger::Error("Unkown color format for {} : {} : Hex number is too big", value, map.at(value));
-			return BLACK;
+		case FIELD_LIFETIME:                 WriteFloatField(payload, emitter.GetParticleLifetime()); break;
+		case FIELD_RESOLUTION:               WriteVector2Field(payload, emitter.GetParticleResolution()); break;
+		case FIELD_MIN_SIZE_FACTOR:          WriteFloatField(payload, emitter.GetParticleMinSizeFactor()); break;
+		case FIELD_MAX_SIZE_FACTOR:          WriteFloatField(payload, emitter.GetParticleMaxSizeFactor()); break;
+		case FIELD_VELOCITY:                 WriteVector2Field(payload, emitter.GetSpawnVelocity()); break;
+		case FIELD_ACCELERATION:             WriteVector2Field(payload, emitter.GetParticleAcceleration()); break;
+		case FIELD_CENTRIPETAL_ACCELERATION: WriteFloatField(payload, emitter.GetCentripetalAcceleration()); break;
+		case FIELD_ROTATION:                 WriteFloatField(payload, emitter.GetParticleSpawnRotation()); break;
+		case FIELD_ROTATION_VELOCITY:        WriteFloatField(payload, emitter.GetParticleSpawnRotationVelocity()); break;
+		case FIELD_ROTATION_ACCELERATION:    WriteFloatField(payload, emitter.GetParticleRotationAcceleration()); break;
+		case FIELD_START_COLOR:              WriteColorField(payload, emitter.GetStartColor()); break;
+		case FIELD_END_COLOR:                WriteColorField(payload, emitter.GetEndColor()); break;
+		case FIELD_SPAWN_INTERVAL:           WriteFloatField(payload, emitter.GetSpawnInterval()); break;
+		case FIELD_RANDOMNESS:               WriteFloatField(payload, emitter.GetRandomness()); break;
+		case FIELD_SPREAD:                   WriteFloatField(payload, emitter.GetSpread()); break;
 		}
+	}
+
+	static constexpr std::string_view FIELD_NAMES[FIELD_COUNT] = {
+		"LIFETIME",
+		"RESOLUTION",
+		"MIN_SIZE_FACTOR",
+		"MAX_SIZE_FACTOR",
+		"VELOCITY",
+		"ACCELERATION",
+		"CENTRIPETAL_ACCELERATION",
+		"ROTATION",
+		"ROTATION_VELOCITY",
+		"ROTATION_ACCELERATION",
+		"START_COLOR",
+		"END_COLOR",
+		"SPAWN_INTERVAL",
+		"RANDOMNESS",
+		"SPREAD"
+	};
+
+	// Bindings are saved as "BIND_<target> : expr : <expression>;" after the properties
+	static constexpr std::string_view BINDING_PREFIX = "BIND_";
+	// Optional, only written when prewarm is set
+	static constexpr std::string_view PREWARM_NAME = "PREWARM";
 
-		std::string aStr = hex.substr(0, 2);
-		std::string rStr = hex.substr(2, 2);
-		std::string gStr = hex.substr(4, 2);
-		std::string bStr = hex.substr(6, 2);
-		
-		int a = ParseHexNumber(aStr);
-		int r = ParseHexNumber(rStr);
-		int g = ParseHexNumber(gStr);
-		int b = ParseHexNumber(bStr);
+	struct FieldValue
+	{
+		float x = 0.0f;
+		float y = 0.0f;
+		Color color = BLACK;
+	};
+
+	static void ApplyField(FieldId id, const FieldValue& value, ParticleEmitter* emitter)
+	{
+		Vector2 v = {value.x, value.y};
 
-		if (a < 0 || r < 0 || g < 0 || b < 0)
+		switch (id)
 		{
-			Logger::Error("Unkown color format for {} : {} : Failed to convert hex", value, map.at(value));
-			return BLACK;
+		case FIELD_LIFETIME:                 emitter->SetParticleLifetime(value.x); break;
+		case FIELD_RESOLUTION:               emitter->SetParticleResolution(v); break;
+		case FIELD_MIN_SIZE_FACTOR:          emitter->SetParticleMinSizeFactor(value.x); break;
+		case FIELD_MAX_SIZE_FACTOR:          emitter->SetParticleMaxSizeFactor(value.x); break;
+		case FIELD_VELOCITY:                 emitter->SetSpawnVelocity(v); break;
+		case FIELD_ACCELERATION:             emitter->SetParticleAcceleration(v); break;
+		case FIELD_CENTRIPETAL_ACCELERATION: emitter->SetCentripetalAcceleration(value.x); break;
+		case FIELD_ROTATION:                 emitter->SetParticleSpawnRotation(value.x); break;
+		case FIELD_ROTATION_VELOCITY:        emitter->SetParticleSpawnRotationVelocity(value.x); break;
+		case FIELD_ROTATION_ACCELERATION:    emitter->SetParticleRotationAcceleration(value.x); break;
+		case FIELD_START_COLOR:              emitter->SetStartColor(value.color); break;
+		case FIELD_END_COLOR:                emitter->SetEndColor(value.color); break;
+		case FIELD_SPAWN_INTERVAL:           emitter->SetSpawnInterval(value.x); break;
+		case FIELD_RANDOMNESS:               emitter->SetRandomness(value.x); break;
+		case FIELD_SPREAD:                   emitter->SetSpread(value.x); break;
 		}
+	}
 
-		return {(unsigned char)r, (unsigned char)g, (unsigned char)b, (unsigned char)a};
+	static void DecodeField(const unsigned char* payload, FieldId id, ParticleEmitter* emitter)
+	{
+		FieldValue value;
+		value.x = ReadF32(payload);
+		value.y = ReadF32(payload + 4);
+		value.color = {payload[0], payload[1], payload[2], payload[3]};
+		ApplyField(id, value, emitter);
 	}
 
-	void Serialize(const std::string& filename, const std::string& emitter_name, const ParticleEmitter& emitter)
+	// Single pass tokenizer over the text format, never copies the input
+	struct TextParser
 	{
-		std::ofstream out(filename);
-		if (!out)
+		std::string_view text;
+		std::string_view source;
+		size_t pos = 0;
+		size_t lineStart = 0;
+		int line = 1;
+
+		int Column() const
 		{
-			Logger::Error("Couldn't open file {}: {}", filename, std::strerror(errno));
-			return;
+			return (int)(pos - lineStart) + 1;
+		}
+
+		bool AtEnd() const
+		{
+			return pos >= text.size();
+		}
+
+		char Peek() const
+		{
+			return AtEnd() ? '\0' : text[pos];
+		}
+
+		void SkipSpaces()
+		{
+			while (!AtEnd() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r'))
+				pos++;
+		}
+
+		void SkipWhitespace()
+		{
+			while (!AtEnd())
+			{
+				if (text[pos] == '\n')
+				{
+					pos++;
+					line++;
+					lineStart = pos;
+				}
+				else if (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r')
+					pos++;
+				else
+					break;
+			}
+		}
+
+		void SkipLine()
+		{
+			while (!AtEnd() && text[pos] != '\n')
+				pos++;
+		}
+
+		bool Expect(char ch)
+		{
+			SkipSpaces();
+			if (Peek() != ch)
+				return false;
+			pos++;
+			return true;
+		}
+
+		std::string_view ReadIdentifier()
+		{
+			SkipSpaces();
+			size_t start = pos;
+			while (!AtEnd() && (std::isalnum((unsigned char)text[pos]) || text[pos] == '_'))
+				pos++;
+			return text.substr(start, pos - start);
+		}
+
+		bool ReadFloat(float* value)
+		{
+			SkipSpaces();
+			std::from_chars_result result = std::from_chars(text.data() + pos, text.data() + text.size(), *value);
+			if (result.ec != std::errc())
+				return false;
+			pos = result.ptr - text.data();
+			return true;
+		}
+
+		// Raw expression source up to the terminating ';' on the same line
+		bool ReadExpression(std::string_view* expression)
+		{
+			SkipSpaces();
+			size_t start = pos;
+			while (!AtEnd() && text[pos] != ';' && text[pos] != '\n')
+				pos++;
+			if (Peek() != ';')
+				return false;
+
+			*expression = text.substr(start, pos - start);
+			pos++;
+			return true;
+		}
+
+		bool ReadVector2(FieldValue* value)
+		{
+			return Expect('{') && ReadFloat(&value->x) && Expect(',') && ReadFloat(&value->y) && Expect('}');
+		}
+
+		bool ReadColor(FieldValue* value)
+		{
+			if (!Expect('#') || text.size() - pos < 8)
+				return false;
+
+			unsigned char channels[4];
+			for (int i = 0; i < 4; i++)
+			{
+				int high = ParseHexDigit(text[pos + i * 2]);
+				int low = ParseHexDigit(text[pos + i * 2 + 1]);
+				if (high < 0 || low < 0)
+					return false;
+				channels[i] = (unsigned char)(high * 0x10 + low);
+			}
+			pos += 8;
+
+			// Stored as AARRGGBB
+			value->color = {channels[1], channels[2], channels[3], channels[0]};
+			return true;
+		}
+
+		template<typename... Args>
+		bool Error(fmt::format_string<Args...> format, Args&&... args) const
+		{
+			Logger::Error("{}:{}:{}: {}", source, line, Column(), fmt::format(format, std::forward<Args>(args)...));
+			return false;
 		}
 
+		template<typename... Args>
+		void Warning(fmt::format_string<Args...> format, Args&&... args) const
+		{
+			LOG_WARN("{}:{}:{}: {}", source, line, Column(), fmt::format(format, std::forward<Args>(args)...));
+		}
+	};
+
+	static int FindField(std::string_view name)
+	{
+		for (int i = 0; i < FIELD_COUNT; i++)
+		{
+			if (name == FIELD_NAMES[i])
+				return i + 1;
+		}
+		return 0;
+	}
+
+	static FieldType ParseFieldType(std::string_view name)
+	{
+		if (name == "float")
+			return FieldType::Float;
+		if (name == "vector2f")
+			return FieldType::Vector2;
+		if (name == "color")
+			return FieldType::Color;
+		return (FieldType)0;
+	}
+
+	static const char* FieldTypeName(FieldType type)
+	{
+		switch (type)
+		{
+		case FieldType::Float:   return "float";
+		case FieldType::Vector2: return "vector2f";
+		case FieldType::Color:   return "color";
+		}
+		return "unknown";
+	}
+
+	static void WriteText(std::ostream& out, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras)
+	{
 		out << emitter_name << "\n{\n";
 		OutFloat(out, "LIFETIME", emitter.GetParticleLifetime());
 		OutVector2(out, "RESOLUTION", emitter.GetParticleResolution());
@@ -172,74 +455,642 @@ namespace ParticleSerializer
 		OutFloat(out, "SPAWN_INTERVAL", emitter.GetSpawnInterval());
 		OutFloat(out, "RANDOMNESS", emitter.GetRandomness());
 		OutFloat(out, "SPREAD", emitter.GetSpread());
+		if (extras)
+		{
+			if (extras->prewarm > 0.0f)
+				OutFloat(out, std::string(PREWARM_NAME), extras->prewarm);
+			for (int i = 0; i < PropertyBindings::COUNT; i++)
+			{
+				BindingTarget target = (BindingTarget)i;
+				if (extras->bindings.IsBound(target))
+					out << "\t" << BINDING_PREFIX << PropertyBindings::GetName(target) << " : expr : " << extras->bindings.GetExpression(target).GetSource() << ";\n";
+			}
+		}
 		out << "}";
+	}
+
+	bool Serialize(const std::string& filename, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras)
+	{
+		TRACE_SCOPE("ParticleSerializer::Serialize");
+
+		std::ofstream out(filename);
+		if (!out)
+		{
+			Logger::Error("Couldn't open file {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+
+		WriteText(out, emitter_name, emitter, extras);
 		out.close();
 
 		LOG_INFO("Saved emitter to {} as {}", filename, emitter_name);
+		return true;
+	}
+
+	// Parses one "name { fields }" block and leaves the parser after its closing brace
+	static bool ParseEmitter(TextParser& parser, ParticleEmitter* emitter, std::string* emitter_name, EmitterExtras* extras)
+	{
+		parser.SkipWhitespace();
+		size_t nameStart = parser.pos;
+		parser.SkipLine();
+		std::string_view name = parser.text.substr(nameStart, parser.pos - nameStart);
+		while (!name.empty() && (name.back() == ' ' || name.back() == '\t' || name.back() == '\r'))
+			name.remove_suffix(1);
+
+		parser.SkipWhitespace();
+		if (parser.Peek() == '{')
+			parser.pos++;
+		else
+			parser.Warning("Expected {{ after the emitter name");
+
+		// Staged so a malformed file leaves the emitter untouched
+		FieldValue values[FIELD_COUNT];
+		bool seen[FIELD_COUNT] = {};
+		PropertyBindings bindings;
+		float prewarm = 0.0f;
+
+		while (true)
+		{
+			parser.SkipWhitespace();
+			if (parser.AtEnd())
+			{
+				parser.Warning("Missing closing }}");
+				break;
+			}
+			if (parser.Peek() == '}')
+			{
+				parser.pos++;
+				break;
+			}
+
+			std::string_view fieldName = parser.ReadIdentifier();
+			if (fieldName.empty())
+				return parser.Error("Expected a property name, found '{}'", parser.Peek());
+
+			int id = FindField(fieldName);
+			BindingTarget target;
+			if (id == 0 && fieldName.substr(0, BINDING_PREFIX.size()) == BINDING_PREFIX && PropertyBindings::FindTarget(fieldName.substr(BINDING_PREFIX.size()), &target))
+			{
+				if (!parser.Expect(':') || parser.ReadIdentifier() != "expr" || !parser.Expect(':'))
+					return parser.Error("Expected {} : expr : <expression>;", fieldName);
+
+				std::string_view expression;
+				if (!parser.ReadExpression(&expression))
+					return parser.Error("Expected ';' after the expression of {}", fieldName);
+
+				std::string error;
+				if (!bindings.Bind(target, expression, &error))
+					return parser.Error("Invalid expression for {}: {}", fieldName, error);
+				continue;
+			}
+			if (id == 0 && fieldName == PREWARM_NAME)
+			{
+				if (!parser.Expect(':') || parser.ReadIdentifier() != "float" || !parser.Expect(':') || !parser.ReadFloat(&prewarm) || !parser.Expect(';'))
+					return parser.Error("Expected {} : float : <seconds>;", fieldName);
+				prewarm = std::max(prewarm, 0.0f);
+				continue;
+			}
+			if (id == 0)
+			{
+				parser.Warning("Unknown property {}, skipping line", fieldName);
+				parser.SkipLine();
+				continue;
+			}
+
+			if (!parser.Expect(':'))
+				return parser.Error("Expected ':' after {}", fieldName);
+
+			std::string_view typeName = parser.ReadIdentifier();
+			FieldType type = ParseFieldType(typeName);
+			if (type != FIELD_TYPES[id - 1])
+				return parser.Error("{} has type '{}', expected '{}'", fieldName, typeName, FieldTypeName(FIELD_TYPES[id - 1]));
+
+			if (!parser.Expect(':'))
+				return parser.Error("Expected ':' after {} : {}", fieldName, typeName);
+
+			FieldValue& value = values[id - 1];
+			bool parsed = false;
+			switch (type)
+			{
+			case FieldType::Float:   parsed = parser.ReadFloat(&value.x); break;
+			case FieldType::Vector2: parsed = parser.ReadVector2(&value); break;
+			case FieldType::Color:   parsed = parser.ReadColor(&value); break;
+			}
+			if (!parsed)
+				return parser.Error("Malformed {} value for {}", typeName, fieldName);
+
+			if (!parser.Expect(';'))
+				return parser.Error("Expected ';' after {}", fieldName);
+
+			if (seen[id - 1])
+				parser.Warning("{} is set more than once, keeping the last value", fieldName);
+			seen[id - 1] = true;
+		}
+
+		bool complete = true;
+		for (int i = 0; i < FIELD_COUNT; i++)
+		{
+			if (!seen[i])
+			{
+				Logger::Error("{}:{}: Missing property {}", parser.source, parser.line, FIELD_NAMES[i]);
+				complete = false;
+			}
+		}
+		if (!complete)
+			return false;
+
+		for (int i = 0; i < FIELD_COUNT; i++)
+			ApplyField((FieldId)(i + 1), values[i], emitter);
+
+		if (emitter_name)
+			emitter_name->assign(name);
+		if (extras)
+		{
+			extras->bindings = bindings;
+			extras->prewarm = prewarm;
+		}
+
+		return true;
+	}
+
+	bool ParseText(std::string_view text, ParticleEmitter* emitter, std::string* emitter_name, std::string_view source, EmitterExtras* extras)
+	{
+		TRACE_SCOPE("ParticleSerializer::ParseText");
+
+		TextParser parser;
+		parser.text = text;
+		parser.source = source;
+		return ParseEmitter(parser, emitter, emitter_name, extras);
+	}
+
+	bool Deserialize(const std::string& filename, ParticleEmitter* emitter, std::string* emitter_name, EmitterExtras* extras)
+	{
+		TRACE_SCOPE("ParticleSerializer::Deserialize");
+
+		std::ifstream in(filename, std::ios::binary | std::ios::ate);
+		if (!in)
+		{
+			Logger::Error("Could not open {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+
+		std::string text;
+		text.resize((size_t)in.tellg());
+		in.seekg(0);
+		in.read(text.data(), text.size());
+		in.close();
+
+		if (!ParseText(text, emitter, emitter_name, filename, extras))
+		{
+			Logger::Error("Failed to open {}", filename);
+			return false;
+		}
+
+		LOG_INFO("Succesfully opened {}", filename);
+		return true;
+	}
+
+	size_t EncodeBinary(unsigned char* buffer, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras)
+	{
+		size_t nameLength = std::min(emitter_name.size(), BINARY_NAME_SIZE - 1);
+
+		std::memcpy(buffer, BINARY_MAGIC, 4);
+		WriteU16(buffer + 4, BINARY_VERSION);
+		WriteU16(buffer + 6, FIELD_COUNT);
+		WriteU16(buffer + 8, (unsigned short)nameLength);
+		WriteU16(buffer + 10, 0);
+
+		unsigned char* name = buffer + BINARY_HEADER_SIZE;
+		std::memset(name, 0, BINARY_NAME_SIZE);
+		std::memcpy(name, emitter_name.data(), nameLength);
+
+		unsigned char* field = name + BINARY_NAME_SIZE;
+		for (unsigned short id = 1; id <= FIELD_COUNT; id++)
+		{
+			EncodeField(field, (FieldId)id, emitter);
+			field += BINARY_FIELD_SIZE;
+		}
+
+		// Version 2: bindings section, u16 count then { u16 target, u16 length, source }
+		unsigned char* section = field;
+		unsigned short bindingCount = 0;
+		unsigned char* binding = section + 2;
+		for (int i = 0; extras && i < PropertyBindings::COUNT; i++)
+		{
+			BindingTarget target = (BindingTarget)i;
+			if (!extras->bindings.IsBound(target))
+				continue;
+
+			// A cut expression would usually fail to compile on load
+			const std::string& source = extras->bindings.GetExpression(target).GetSource();
+			size_t length = source.size();
+			if (length > BINARY_MAX_EXPRESSION)
+			{
+				Logger::Error("Binding expression of {} is {} characters, the binary format holds at most {}", emitter_name, length, BINARY_MAX_EXPRESSION);
+				return 0;
+			}
+			WriteU16(binding, (unsigned short)i);
+			WriteU16(binding + 2, (unsigned short)length);
+			std::memcpy(binding + 4, source.data(), length);
+			binding += 4 + length;
+			bindingCount++;
+		}
+		WriteU16(section, bindingCount);
+
+		// Version 3: f32 prewarm seconds
+		WriteF32(binding, extras ? extras->prewarm : 0.0f);
+
+		return binding + 4 - buffer;
+	}
+
+	bool DecodeBinary(const unsigned char* data, size_t size, ParticleEmitter* emitter, std::string* emitter_name, EmitterExtras* extras)
+	{
+		if (size < BINARY_HEADER_SIZE + BINARY_NAME_SIZE || std::memcmp(data, BINARY_MAGIC, 4) != 0)
+		{
+			LOG_ERROR("Not a binary emitter");
+			return false;
+		}
+
+		unsigned short version = ReadU16(data + 4);
+		if (version > BINARY_VERSION)
+		{
+			Logger::Error("Unsupported binary emitter version {} (newest known is {})", version, BINARY_VERSION);
+			return false;
+		}
+
+		unsigned short fieldCount = ReadU16(data + 6);
+		unsigned short nameLength = ReadU16(data + 8);
+		if (nameLength >= BINARY_NAME_SIZE || size < BINARY_HEADER_SIZE + BINARY_NAME_SIZE + fieldCount * BINARY_FIELD_SIZE)
+		{
+			LOG_ERROR("Binary emitter is truncated");
+			return false;
+		}
+
+		// Validate the whole table first so a bad file leaves the emitter untouched
+		const unsigned char* fields = data + BINARY_HEADER_SIZE + BINARY_NAME_SIZE;
+		for (unsigned short i = 0; i < fieldCount; i++)
+		{
+			const unsigned char* field = fields + i * BINARY_FIELD_SIZE;
+			unsigned short id = ReadU16(field);
+			unsigned short type = ReadU16(field + 2);
+			if (id >= 1 && id <= FIELD_COUNT && type != (unsigned short)FIELD_TYPES[id - 1])
+			{
+				Logger::Error("Binary emitter field {} has type {}, expected {}", id, type, (unsigned short)FIELD_TYPES[id - 1]);
+				return false;
+			}
+		}
+
+		// Version 1 files end after the field table
+		PropertyBindings bindings;
+		float prewarm = 0.0f;
+		const unsigned char* section = fields + fieldCount * BINARY_FIELD_SIZE;
+		const unsigned char* end = data + size;
+		if (version >= 2 && section + 2 <= end)
+		{
+			unsigned short bindingCount = ReadU16(section);
+			const unsigned char* binding = section + 2;
+			for (unsigned short i = 0; i < bindingCount; i++)
+			{
+				if (binding + 4 > end || binding + 4 + ReadU16(binding + 2) > end)
+				{
+					LOG_ERROR("Binary emitter bindings are truncated");
+					return false;
+				}
+
+				unsigned short target = ReadU16(binding);
+				std::string_view source((const char*)binding + 4, ReadU16(binding + 2));
+				binding += 4 + source.size();
+
+				// Unknown targets come from newer files, skip them
+				std::string error;
+				if (target < PropertyBindings::COUNT && !bindings.Bind((BindingTarget)target, source, &error))
+				{
+					Logger::Error("Invalid expression for {}: {}", PropertyBindings::GetName((BindingTarget)target), error);
+					return false;
+				}
+			}
+
+			// Version 2 files end after the bindings
+			if (version >= 3 && binding + 4 <= end)
+				prewarm = std::max(ReadF32(binding), 0.0f);
+		}
+
+		for (unsigned short i = 0; i < fieldCount; i++)
+		{
+			const unsigned char* field = fields + i * BINARY_FIELD_SIZE;
+			unsigned short id = ReadU16(field);
+			// Unknown ids come from newer files, skip them
+			if (id >= 1 && id <= FIELD_COUNT)
+				DecodeField(field + 4, (FieldId)id, emitter);
+		}
+
+		if (emitter_name)
+			emitter_name->assign((const char*)(data + BINARY_HEADER_SIZE), nameLength);
+		if (extras)
+		{
+			extras->bindings = bindings;
+			extras->prewarm = prewarm;
+		}
+
+		return true;
+	}
+
+	bool SerializeBinary(const std::string& filename, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras)
+	{
+		TRACE_SCOPE("ParticleSerializer::SerializeBinary");
+
+		unsigned char buffer[BINARY_MAX_SIZE];
+		size_t size = EncodeBinary(buffer, emitter_name, emitter, extras);
+		if (size == 0)
+		{
+			Logger::Error("Couldn't save {}", filename);
+			return false;
+		}
+
+		FILE* file = std::fopen(filename.c_str(), "wb");
+		if (!file)
+		{
+			Logger::Error("Couldn't open file {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+		bool written = std::fwrite(buffer, 1, size, file) == size;
+		std::fclose(file);
+
+		if (!written)
+		{
+			Logger::Error("Couldn't write {}", filename);
+			return false;
+		}
+
+		LOG_INFO("Saved emitter to {} as {}", filename, emitter_name);
+		return true;
+	}
+
+	bool DeserializeBinary(const std::string& filename, ParticleEmitter* emitter, std::string* emitter_name, EmitterExtras* extras)
+	{
+		TRACE_SCOPE("ParticleSerializer::DeserializeBinary");
+
+		FILE* file = std::fopen(filename.c_str(), "rb");
+		if (!file)
+		{
+			Logger::Error("Could not open {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+
+		unsigned char buffer[BINARY_MAX_SIZE];
+		size_t size = std::fread(buffer, 1, sizeof(buffer), file);
+		std::fclose(file);
+
+		if (!DecodeBinary(buffer, size, emitter, emitter_name, extras))
+		{
+			Logger::Error("Failed to open {}", filename);
+			return false;
+		}
+
+		LOG_INFO("Succesfully opened {}", filename);
+		return true;
+	}
+
+	bool ConvertTextToBinary(const std::string& text_filename, const std::string& binary_filename)
+	{
+		ParticleEmitter emitter;
+		std::string name;
+		EmitterExtras extras;
+		if (!Deserialize(text_filename, &emitter, &name, &extras))
+			return false;
+
+		return SerializeBinary(binary_filename, name, emitter, &extras);
+	}
+
+	bool ConvertBinaryToText(const std::string& binary_filename, const std::string& text_filename)
+	{
+		ParticleEmitter emitter;
+		std::string name;
+		EmitterExtras extras;
+		if (!DeserializeBinary(binary_filename, &emitter, &name, &extras))
+			return false;
+
+		return Serialize(text_filename, name, emitter, &extras);
+	}
+
+	bool SerializeBank(const std::string& filename, const std::vector<BankEmitter>& emitters)
+	{
+		TRACE_SCOPE("ParticleSerializer::SerializeBank");
+
+		std::set<std::string_view> names;
+		for (const BankEmitter& entry : emitters)
+		{
+			if (!names.insert(entry.name).second)
+			{
+				Logger::Error("Emitter {} appears twice in bank {}", entry.name, filename);
+				return false;
+			}
+		}
+
+		// Keep the table at most half full so probes stay short
+		size_t slotCount = 1;
+		while (slotCount < emitters.size() * 2)
+			slotCount *= 2;
+
+		size_t entriesOffset = EmitterBank::HEADER_SIZE;
+		size_t slotsOffset = entriesOffset + emitters.size() * EmitterBank::ENTRY_SIZE;
+		size_t namesOffset = slotsOffset + slotCount * EmitterBank::SLOT_SIZE;
+		size_t recordsOffset = namesOffset;
+		for (const BankEmitter& entry : emitters)
+			recordsOffset += entry.name.size();
+
+		std::vector<unsigned char> bank(recordsOffset, 0);
+		std::memcpy(bank.data(), "PEBK", 4);
+		WriteU16(&bank[4], EmitterBank::VERSION);
+		WriteU32(&bank[8], emitters.size());
+		WriteU32(&bank[12], slotCount);
+		WriteU32(&bank[16], entriesOffset);
+		WriteU32(&bank[20], slotsOffset);
+		WriteU32(&bank[24], namesOffset);
+
+		size_t nameOffset = namesOffset;
+		unsigned char record[BINARY_MAX_SIZE];
+		for (size_t i = 0; i < emitters.size(); i++)
+		{
+			const BankEmitter& entry = emitters[i];
+			size_t recordSize = EncodeBinary(record, entry.name, entry.emitter, &entry.extras);
+			if (recordSize == 0)
+			{
+				Logger::Error("Couldn't pack {}", entry.name);
+				return false;
+			}
+			size_t recordOffset = bank.size();
+			bank.insert(bank.end(), record, record + recordSize);
+
+			unsigned char* out = &bank[entriesOffset + i * EmitterBank::ENTRY_SIZE];
+			WriteU32(out, nameOffset);
+			WriteU32(out + 4, entry.name.size());
+			WriteU32(out + 8, recordOffset);
+			WriteU32(out + 12, recordSize);
+
+			std::memcpy(&bank[nameOffset], entry.name.data(), entry.name.size());
+			nameOffset += entry.name.size();
+
+			uint64_t hash = EmitterBank::Hash(entry.name);
+			for (size_t probe = 0; ; probe++)
+			{
+				unsigned char* slot = &bank[slotsOffset + ((hash + probe) & (slotCount - 1)) * EmitterBank::SLOT_SIZE];
+				if (slot[8] || slot[9] || slot[10] || slot[11])
+					continue;
+
+				WriteU32(slot, hash & 0xFFFFFFFF);
+				WriteU32(slot + 4, hash >> 32);
+				WriteU32(slot + 8, i + 1);
+				break;
+			}
+		}
+
+		FILE* file = std::fopen(filename.c_str(), "wb");
+		if (!file)
+		{
+			Logger::Error("Couldn't open file {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+		bool written = std::fwrite(bank.data(), 1, bank.size(), file) == bank.size();
+		std::fclose(file);
+
+		if (!written)
+		{
+			Logger::Error("Couldn't write {}", filename);
+			return false;
+		}
+
+		LOG_INFO("Saved {} emitters to bank {}", emitters.size(), filename);
+		return true;
+	}
+
+	bool OpenBank(const std::string& filename, EmitterBank* bank)
+	{
+		TRACE_SCOPE("ParticleSerializer::OpenBank");
+
+		if (!bank->Open(filename))
+			return false;
+
+		LOG_INFO("Opened bank {} with {} emitters", filename, bank->GetCount());
+		return true;
+	}
+
+	bool DeserializeFromBank(const EmitterBank& bank, std::string_view emitter_name, ParticleEmitter* emitter, EmitterExtras* extras)
+	{
+		TRACE_SCOPE("ParticleSerializer::DeserializeFromBank");
+
+		size_t recordSize = 0;
+		const unsigned char* record = bank.Find(emitter_name, &recordSize);
+		if (!record)
+		{
+			Logger::Error("Bank {} has no emitter named {}", bank.GetFilename(), emitter_name);
+			return false;
+		}
+
+		return DecodeBinary(record, recordSize, emitter, nullptr, extras);
+	}
+
+	std::vector<std::string_view> EnumerateBank(const EmitterBank& bank)
+	{
+		std::vector<std::string_view> names;
+		names.reserve(bank.GetCount());
+		for (size_t i = 0; i < bank.GetCount(); i++)
+			names.push_back(bank.GetName(i));
+
+		return names;
+	}
+
+	static constexpr std::string_view SCENE_BUDGET_NAME = "PARTICLE_BUDGET";
+	static constexpr std::string_view SCENE_POSITION_NAME = "EMITTER_POSITION";
+
+	bool SerializeScene(const std::string& filename, const std::vector<SceneEmitter>& emitters, size_t particle_budget)
+	{
+		TRACE_SCOPE("ParticleSerializer::SerializeScene");
+
+		std::ofstream out(filename);
+		if (!out)
+		{
+			Logger::Error("Couldn't open file {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+
+		out << SCENE_BUDGET_NAME << " : " << particle_budget << ";\n";
+		for (const SceneEmitter& entry : emitters)
+		{
+			out << "\n" << SCENE_POSITION_NAME << " : { " << entry.position.x << ", " << entry.position.y << " };\n";
+			WriteText(out, entry.name, entry.emitter, &entry.extras);
+			out << "\n";
+		}
+		out.close();
+
+		LOG_INFO("Saved scene with {} emitters to {}", emitters.size(), filename);
+		return true;
 	}
 
-	void Deserialize(const std::string& filename, ParticleEmitter* emitter)
+	bool DeserializeScene(const std::string& filename, std::vector<SceneEmitter>* emitters, size_t* particle_budget)
 	{
-		std::ifstream in(filename);
+		TRACE_SCOPE("ParticleSerializer::DeserializeScene");
+
+		std::ifstream in(filename, std::ios::binary | std::ios::ate);
 		if (!in)
 		{
 			Logger::Error("Could not open {}: {}", filename, std::strerror(errno));
-			return;
+			return false;
 		}
-		std::stringstream ss;
-		ss << in.rdbuf();
+
+		std::string text;
+		text.resize((size_t)in.tellg());
+		in.seekg(0);
+		in.read(text.data(), text.size());
 		in.close();
 
-		std::map<std::string, std::string> exprs;
+		TextParser parser;
+		parser.text = text;
+		parser.source = filename;
 
-		std::string line;
-		std::getline(ss, line);
-		std::string name = line;
-		std::getline(ss, line);
-		if (line[0] != '{')
-			LOG_WARN("Second line should only consist of {");
-		while (std::getline(ss, line))
+		// Staged so a malformed scene leaves the current one untouched
+		std::vector<SceneEmitter> loaded;
+		float budget = 0.0f;
+		while (true)
 		{
-			size_t sepPos = line.find(":");
-			if (sepPos == line.npos)
+			parser.SkipWhitespace();
+			if (parser.AtEnd())
+				break;
+
+			std::string_view name = parser.ReadIdentifier();
+			if (name == SCENE_BUDGET_NAME)
 			{
-				if (line[0] != '}')
-					LOG_WARN("Couldn't resolve line: \"{}\"", line);
+				if (!parser.Expect(':') || !parser.ReadFloat(&budget) || budget < 1.0f || !parser.Expect(';'))
+					return parser.Error("Expected {} : <particles>;", name);
 				continue;
 			}
-			std::string name = line.substr(0, sepPos);
-			std::string rest = line.substr(sepPos + 1);
-			name = trim(name);
-			rest = trim(rest);
+			if (name != SCENE_POSITION_NAME)
+				return parser.Error("Expected {} or {} before each emitter", SCENE_BUDGET_NAME, SCENE_POSITION_NAME);
 
-			sepPos = rest.find(":");
-			if (sepPos == rest.npos)
+			SceneEmitter& entry = loaded.emplace_back();
+			FieldValue position;
+			if (!parser.Expect(':') || !parser.ReadVector2(&position) || !parser.Expect(';'))
+				return parser.Error("Expected {} : {{ x, y }};", name);
+			entry.position = {position.x, position.y};
+
+			if (!ParseEmitter(parser, &entry.emitter, &entry.name, &entry.extras))
 			{
-				LOG_WARN("Couldn't resolve line: \"{}\"", line);
-				continue;
+				Logger::Error("Failed to open scene {}", filename);
+				return false;
 			}
-			std::string value = rest.substr(sepPos + 1, rest.size() - sepPos - 2);
-			value = trim(value);
+		}
 
-			exprs[name] = value;
+		if (loaded.empty())
+		{
+			Logger::Error("Scene {} has no emitters", filename);
+			return false;
 		}
 
-		emitter->SetParticleLifetime(InGetFloat(exprs, "LIFETIME"));
-		emitter->SetParticleResolution(InGetVector2(exprs, "RESOLUTION"));
-		emitter->SetParticleMinSizeFactor(InGetFloat(exprs, "MIN_SIZE_FACTOR"));
-		emitter->SetParticleMaxSizeFactor(InGetFloat(exprs, "MAX_SIZE_FACTOR"));
-		emitter->SetSpawnVelocity(InGetVector2(exprs, "VELOCITY"));
-		emitter->SetParticleAcceleration(InGetVector2(exprs, "ACCELERATION"));
-		emitter->SetCentripetalAcceleration(InGetFloat(exprs, "CENTRIPETAL_ACCELERATION"));
-		emitter->SetParticleSpawnRotation(InGetFloat(exprs, "ROTATION"));
-		emitter->SetParticleSpawnRotationVelocity(InGetFloat(exprs, "ROTATION_VELOCITY"));
-		emitter->SetParticleRotationAcceleration(InGetFloat(exprs, "ROTATION_ACCELERATION"));
-		emitter->SetStartColor(InGetColor(exprs, "START_COLOR"));
-		emitter->SetEndColor(InGetColor(exprs, "END_COLOR"));
-		emitter->SetSpawnInterval(InGetFloat(exprs, "SPAWN_INTERVAL"));
-		emitter->SetRandomness(InGetFloat(exprs, "RANDOMNESS"));
-		emitter->SetSpread(InGetFloat(exprs, "SPREAD"));
+		emitters->swap(loaded);
+		if (particle_budget && budget >= 1.0f)
+			*particle_budget = (size_t)budget;
 
-		LOG_INFO("Succesfully opened {}", filename);
+		LOG_INFO("Opened scene {} with {} emitters", filename, emitters->size());
+		return true;
 	}
 }
@@ -1,10 +1,71 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
 #include <Difu/Particles/ParticleEmitter.h>
 
-namespace ParticleSerializer 
+#include "EmitterBank.h"
+#include "EmitterExtras.h"
+
+namespace ParticleSerializer
 {
-	void Serialize(const std::string& filename, const std::string& emitter_name, const ParticleEmitter& emitter);
-	void Deserialize(const std::string& filename, ParticleEmitter* emitter);
+	// Binary emitter layout (little-endian):
+	//   header : "PEMB" magic, u16 version, u16 field count, u16 name length, u16 reserved
+	//   name   : 64 bytes, zero padded
+	//   fields : field count * { u16 id, u16 type, 8 byte payload }
+	//   since version 2, bindings : u16 count, count * { u16 target, u16 length, expression source }
+	//   since version 3, extras : f32 prewarm seconds
+	constexpr size_t BINARY_HEADER_SIZE = 12;
+	constexpr size_t BINARY_NAME_SIZE = 64;
+	constexpr size_t BINARY_FIELD_SIZE = 12;
+	constexpr size_t BINARY_MAX_FIELDS = 32;
+	// Expression::Compile rejects longer sources, so every expression that loads also saves
+	constexpr size_t BINARY_MAX_EXPRESSION = Expression::MAX_SOURCE_LENGTH;
+	constexpr size_t BINARY_MAX_SIZE = BINARY_HEADER_SIZE + BINARY_NAME_SIZE + BINARY_MAX_FIELDS * BINARY_FIELD_SIZE
+		+ 2 + PropertyBindings::COUNT * (4 + BINARY_MAX_EXPRESSION) + 4;
+	constexpr unsigned short BINARY_VERSION = 3;
+
+	// Extras are optional everywhere: when given they are saved, and replaced on a successful load
+	bool Serialize(const std::string& filename, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras = nullptr);
+	bool Deserialize(const std::string& filename, ParticleEmitter* emitter, std::string* emitter_name = nullptr, EmitterExtras* extras = nullptr);
+	// Parses the text format without copying it, errors are reported as source:line:column
+	bool ParseText(std::string_view text, ParticleEmitter* emitter, std::string* emitter_name = nullptr, std::string_view source = "<memory>", EmitterExtras* extras = nullptr);
+
+	bool SerializeBinary(const std::string& filename, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras = nullptr);
+	bool DeserializeBinary(const std::string& filename, ParticleEmitter* emitter, std::string* emitter_name = nullptr, EmitterExtras* extras = nullptr);
+
+	// Encodes into buffer (at least BINARY_MAX_SIZE bytes), returns the number of bytes written.
+	// Returns 0 and logs an error if a binding expression is longer than BINARY_MAX_EXPRESSION.
+	size_t EncodeBinary(unsigned char* buffer, const std::string& emitter_name, const ParticleEmitter& emitter, const EmitterExtras* extras = nullptr);
+	bool DecodeBinary(const unsigned char* data, size_t size, ParticleEmitter* emitter, std::string* emitter_name = nullptr, EmitterExtras* extras = nullptr);
+
+	bool ConvertTextToBinary(const std::string& text_filename, const std::string& binary_filename);
+	bool ConvertBinaryToText(const std::string& binary_filename, const std::string& text_filename);
+
+	struct BankEmitter
+	{
+		std::string name;
+		ParticleEmitter emitter;
+		EmitterExtras extras;
+	};
+
+	bool SerializeBank(const std::string& filename, const std::vector<BankEmitter>& emitters);
+	bool OpenBank(const std::string& filename, EmitterBank* bank);
+	bool DeserializeFromBank(const EmitterBank& bank, std::string_view emitter_name, ParticleEmitter* emitter, EmitterExtras* extras = nullptr);
+	std::vector<std::string_view> EnumerateBank(const EmitterBank& bank);
+
+	struct SceneEmitter
+	{
+		std::string name;
+		ParticleEmitter emitter;
+		EmitterExtras extras;
+		Vector2 position = {0.0f, 0.0f};
+	};
+
+	// Text scene (.pscene): PARTICLE_BUDGET : n; then for every emitter
+	// EMITTER_POSITION : { x, y }; followed by its block in the text emitter format
+	bool SerializeScene(const std::string& filename, const std::vector<SceneEmitter>& emitters, size_t particle_budget);
+	bool DeserializeScene(const std::string& filename, std::vector<SceneEmitter>* emitters, size_t* particle_budget = nullptr);
 }
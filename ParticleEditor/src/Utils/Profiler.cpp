@@ -0,0 +1,157 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <imgui.h>
+
+namespace Profiler
+{
+	struct Statistics
+	{
+		float last = 0.0f;
+		float min = 0.0f;
+		float average = 0.0f;
+		float p99 = 0.0f;
+	};
+
+	static constexpr int STAGE_COUNT = (int)Stage::COUNT;
+	// The last row holds the whole frame time
+	static constexpr int FRAME_ROW = STAGE_COUNT;
+
+	static float history[STAGE_COUNT + 1][HISTORY] = {};
+	static float current[STAGE_COUNT] = {};
+	static int head = 0;
+	static int filled = 0;
+	static size_t particleCount = 0;
+	static bool particleCountEstimated = false;
+
+	static const char* const STAGE_NAMES[STAGE_COUNT] = {
+		"Update",
+		"Emitter update",
+		"Render viewport",
+		"Emitter render",
+		"Property editor",
+		"ConsoleLog render"
+	};
+
+	void NewFrame(float frameTime)
+	{
+		for (int i = 0; i < STAGE_COUNT; i++)
+		{
+			history[i][head] = current[i];
+			current[i] = 0.0f;
+		}
+		history[FRAME_ROW][head] = frameTime * 1000.0f;
+
+		head = (head + 1) % HISTORY;
+		filled = std::min(filled + 1, HISTORY);
+	}
+
+	void Record(Stage stage, float milliseconds)
+	{
+		// A stage can run several times a frame, the graph shows the total
+		current[(int)stage] += milliseconds;
+	}
+
+	void SetParticleCount(size_t count, bool estimated)
+	{
+		particleCount = count;
+		particleCountEstimated = estimated;
+	}
+
+	const char* GetName(Stage stage)
+	{
+		return STAGE_NAMES[(int)stage];
+	}
+
+	static Statistics GetStatistics(int row)
+	{
+		Statistics statistics;
+		if (filled == 0)
+			return statistics;
+
+		float sorted[HISTORY];
+		float sum = 0.0f;
+		for (int i = 0; i < filled; i++)
+		{
+			sorted[i] = history[row][(head - filled + i + HISTORY) % HISTORY];
+			sum += sorted[i];
+		}
+		statistics.last = history[row][(head - 1 + HISTORY) % HISTORY];
+		statistics.average = sum / filled;
+
+		std::sort(sorted, sorted + filled);
+		statistics.min = sorted[0];
+		statistics.p99 = sorted[std::max(0, (int)std::ceil(filled * 0.99f) - 1)];
+		return statistics;
+	}
+
+	static void PlotHistory(const char* id, int row, float height, const char* overlay)
+	{
+		// The ring buffer starts at head once it is full
+		int offset = filled == HISTORY ? head : 0;
+		ImGui::PlotLines(id, history[row], filled, offset, overlay, 0.0f, FLT_MAX, {-FLT_MIN, height});
+	}
+
+	void DrawWindow(bool* open)
+	{
+		if (!ImGui::Begin("Profiler", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!ENABLED)
+		{
+			ImGui::TextWrapped("Timers are compiled out of this build. Build Debug, or Release with --profile, to enable them.");
+			ImGui::End();
+			return;
+		}
+
+		Statistics frame = GetStatistics(FRAME_ROW);
+		char overlay[64];
+		std::snprintf(overlay, sizeof(overlay), "frame %.2f ms (p99 %.2f ms)", frame.last, frame.p99);
+		PlotHistory("##Frame", FRAME_ROW, 60.0f, overlay);
+
+		Statistics emitterUpdate = GetStatistics((int)Stage::EmitterUpdate);
+		ImGui::Text("Particles%s: %zu", particleCountEstimated ? " (estimated)" : "", particleCount);
+		if (emitterUpdate.average > 0.0f)
+			ImGui::Text("Particles/ms: %.0f", particleCount / emitterUpdate.average);
+
+		ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+		if (ImGui::BeginTable("Stages", 6, flags))
+		{
+			ImGui::TableSetupColumn("Stage");
+			ImGui::TableSetupColumn("Last");
+			ImGui::TableSetupColumn("Min");
+			ImGui::TableSetupColumn("Avg");
+			ImGui::TableSetupColumn("P99");
+			ImGui::TableSetupColumn("History (ms)", ImGuiTableColumnFlags_WidthStretch);
+			ImGui::TableHeadersRow();
+
+			for (int i = 0; i < STAGE_COUNT; i++)
+			{
+				Statistics statistics = GetStatistics(i);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(STAGE_NAMES[i]);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", statistics.last);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", statistics.min);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", statistics.average);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", statistics.p99);
+				ImGui::TableNextColumn();
+				ImGui::PushID(i);
+				PlotHistory("##Stage", i, ImGui::GetTextLineHeight(), nullptr);
+				ImGui::PopID();
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+}
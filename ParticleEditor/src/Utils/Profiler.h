@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// CPU timers for the stages of an editor frame, shown in the "Profiler" window.
+// PROFILE_SCOPE compiles to nothing unless PARTICLE_EDITOR_PROFILE is defined,
+// which premake does for Debug and for Release with --profile.
+namespace Profiler
+{
+	enum class Stage
+	{
+		Update,
+		EmitterUpdate,
+		RenderViewport,
+		EmitterRender,
+		PropertyEditor,
+		ConsoleLogRender,
+		COUNT
+	};
+
+	// Frames kept for the graphs and statistics
+	constexpr int HISTORY = 240;
+
+#ifdef PARTICLE_EDITOR_PROFILE
+	constexpr bool ENABLED = true;
+#else
+	constexpr bool ENABLED = false;
+#endif
+
+	// Closes the previous frame, call once at the start of every frame
+	void NewFrame(float frameTime);
+	void Record(Stage stage, float milliseconds);
+	void SetParticleCount(size_t count, bool estimated = false);
+
+	const char* GetName(Stage stage);
+
+	void DrawWindow(bool* open);
+
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(Stage _stage) : stage(_stage), start(std::chrono::steady_clock::now()) {}
+		~ScopedTimer()
+		{
+			std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			Record(stage, elapsed.count());
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		Stage stage;
+		std::chrono::steady_clock::time_point start;
+	};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PARTICLE_EDITOR_PROFILE
+	#define PROFILE_SCOPE(stage) Profiler::ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(Profiler::Stage::stage)
+#else
+	#define PROFILE_SCOPE(stage)
+#endif
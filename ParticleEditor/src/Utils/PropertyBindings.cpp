@@ -0,0 +1,151 @@
+#include "PropertyBindings.h"
+
+static const char* const TARGET_NAMES[PropertyBindings::COUNT] = {
+	"LIFETIME",
+	"RESOLUTION_X",
+	"RESOLUTION_Y",
+	"MIN_SIZE_FACTOR",
+	"MAX_SIZE_FACTOR",
+	"VELOCITY_X",
+	"VELOCITY_Y",
+	"ACCELERATION_X",
+	"ACCELERATION_Y",
+	"CENTRIPETAL_ACCELERATION",
+	"ROTATION",
+	"ROTATION_VELOCITY",
+	"ROTATION_ACCELERATION",
+	"SPAWN_INTERVAL",
+	"RANDOMNESS",
+	"SPREAD"
+};
+
+PropertyBindings::PropertyBindings()
+{
+}
+
+bool PropertyBindings::Bind(BindingTarget target, std::string_view source, std::string* error)
+{
+	if (source.find_first_not_of(" \t") == source.npos)
+	{
+		Unbind(target);
+		return true;
+	}
+
+	return expressions[(int)target].Compile(source, error);
+}
+
+void PropertyBindings::Unbind(BindingTarget target)
+{
+	expressions[(int)target].Clear();
+}
+
+void PropertyBindings::Clear()
+{
+	for (Expression& expression : expressions)
+		expression.Clear();
+}
+
+bool PropertyBindings::IsBound(BindingTarget target) const
+{
+	return !expressions[(int)target].IsEmpty();
+}
+
+bool PropertyBindings::IsEmpty() const
+{
+	for (const Expression& expression : expressions)
+	{
+		if (!expression.IsEmpty())
+			return false;
+	}
+	return true;
+}
+
+const Expression& PropertyBindings::GetExpression(BindingTarget target) const
+{
+	return expressions[(int)target];
+}
+
+void PropertyBindings::Apply(ParticleEmitter* emitter, float t) const
+{
+	// Only touch bound properties so unbound setters never run
+	auto bound = [this](BindingTarget target) { return !expressions[(int)target].IsEmpty(); };
+	auto value = [this, t](BindingTarget target) { return expressions[(int)target].Evaluate(t); };
+
+	if (bound(BindingTarget::Lifetime))
+		emitter->SetParticleLifetime(value(BindingTarget::Lifetime));
+
+	if (bound(BindingTarget::ResolutionX) || bound(BindingTarget::ResolutionY))
+	{
+		Vector2 resolution = emitter->GetParticleResolution();
+		if (bound(BindingTarget::ResolutionX))
+			resolution.x = value(BindingTarget::ResolutionX);
+		if (bound(BindingTarget::ResolutionY))
+			resolution.y = value(BindingTarget::ResolutionY);
+		emitter->SetParticleResolution(resolution);
+	}
+
+	if (bound(BindingTarget::MinSizeFactor))
+		emitter->SetParticleMinSizeFactor(value(BindingTarget::MinSizeFactor));
+	if (bound(BindingTarget::MaxSizeFactor))
+		emitter->SetParticleMaxSizeFactor(value(BindingTarget::MaxSizeFactor));
+
+	if (bound(BindingTarget::VelocityX) || bound(BindingTarget::VelocityY))
+	{
+		Vector2 velocity = emitter->GetSpawnVelocity();
+		if (bound(BindingTarget::VelocityX))
+			velocity.x = value(BindingTarget::VelocityX);
+		if (bound(BindingTarget::VelocityY))
+			velocity.y = value(BindingTarget::VelocityY);
+		emitter->SetSpawnVelocity(velocity);
+	}
+
+	if (bound(BindingTarget::AccelerationX) || bound(BindingTarget::AccelerationY))
+	{
+		Vector2 acceleration = emitter->GetParticleAcceleration();
+		if (bound(BindingTarget::AccelerationX))
+			acceleration.x = value(BindingTarget::AccelerationX);
+		if (bound(BindingTarget::AccelerationY))
+			acceleration.y = value(BindingTarget::AccelerationY);
+		emitter->SetParticleAcceleration(acceleration);
+	}
+
+	if (bound(BindingTarget::CentripetalAcceleration))
+		emitter->SetCentripetalAcceleration(value(BindingTarget::CentripetalAcceleration));
+	if (bound(BindingTarget::Rotation))
+		emitter->SetParticleSpawnRotation(value(BindingTarget::Rotation));
+	if (bound(BindingTarget::RotationVelocity))
+		emitter->SetParticleSpawnRotationVelocity(value(BindingTarget::RotationVelocity));
+	if (bound(BindingTarget::RotationAcceleration))
+		emitter->SetParticleRotationAcceleration(value(BindingTarget::RotationAcceleration));
+
+	// A zero or negative interval would spawn forever
+	if (bound(BindingTarget::SpawnInterval))
+	{
+		float interval = value(BindingTarget::SpawnInterval);
+		if (interval > 0.0f)
+			emitter->SetSpawnInterval(interval);
+	}
+
+	if (bound(BindingTarget::Randomness))
+		emitter->SetRandomness(value(BindingTarget::Randomness));
+	if (bound(BindingTarget::Spread))
+		emitter->SetSpread(value(BindingTarget::Spread));
+}
+
+const char* PropertyBindings::GetName(BindingTarget target)
+{
+	return TARGET_NAMES[(int)target];
+}
+
+bool PropertyBindings::FindTarget(std::string_view name, BindingTarget* target)
+{
+	for (int i = 0; i < COUNT; i++)
+	{
+		if (name == TARGET_NAMES[i])
+		{
+			*target = (BindingTarget)i;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Expression.h"
+
+#include <string>
+#include <string_view>
+#include <Difu/Particles/ParticleEmitter.h>
+
+// Scalar emitter properties that can be driven by a function of time.
+// Vector properties are bound per component.
+enum class BindingTarget
+{
+	Lifetime,
+	ResolutionX,
+	ResolutionY,
+	MinSizeFactor,
+	MaxSizeFactor,
+	VelocityX,
+	VelocityY,
+	AccelerationX,
+	AccelerationY,
+	CentripetalAcceleration,
+	Rotation,
+	RotationVelocity,
+	RotationAcceleration,
+	SpawnInterval,
+	Randomness,
+	Spread,
+
+	Count
+};
+
+class PropertyBindings
+{
+public:
+	static constexpr int COUNT = (int)BindingTarget::Count;
+
+	PropertyBindings();
+
+	// An empty source removes the binding, a malformed one keeps the previous binding
+	bool Bind(BindingTarget target, std::string_view source, std::string* error = nullptr);
+	void Unbind(BindingTarget target);
+	void Clear();
+
+	bool IsBound(BindingTarget target) const;
+	bool IsEmpty() const;
+	const Expression& GetExpression(BindingTarget target) const;
+
+	// Writes every bound property of the emitter for time t
+	void Apply(ParticleEmitter* emitter, float t) const;
+
+	// Name used in save files, e.g. "VELOCITY_X"
+	static const char* GetName(BindingTarget target);
+	static bool FindTarget(std::string_view name, BindingTarget* target);
+
+private:
+	Expression expressions[COUNT];
+};
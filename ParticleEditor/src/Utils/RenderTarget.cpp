@@ -0,0 +1,89 @@
+#include "RenderTarget.h"
+
+#include <algorithm>
+#include <rlgl.h>
+
+static int allocationCount = 0;
+
+RenderTarget::RenderTarget()
+{
+}
+
+bool RenderTarget::Resize(int _width, int _height)
+{
+	width = std::max(_width, 1);
+	height = std::max(_height, 1);
+
+	if (loaded)
+	{
+		bool fits = width <= texture.texture.width && height <= texture.texture.height;
+		float used = (float)width * height / ((float)texture.texture.width * texture.texture.height);
+		if (fits && used >= SHRINK_THRESHOLD)
+			return false;
+
+		UnloadRenderTexture(texture);
+	}
+
+	texture = LoadRenderTexture((int)(width * SLACK), (int)(height * SLACK));
+	loaded = true;
+	allocationCount++;
+	return true;
+}
+
+void RenderTarget::Unload()
+{
+	if (loaded)
+		UnloadRenderTexture(texture);
+	loaded = false;
+}
+
+void RenderTarget::Begin()
+{
+	BeginTextureMode(texture);
+
+	// Screen y = 0 is the top row of the texture, which is the last one for OpenGL
+	rlEnableScissorTest();
+	rlScissor(0, texture.texture.height - height, width, height);
+}
+
+void RenderTarget::End()
+{
+	rlDrawRenderBatchActive();
+	rlDisableScissorTest();
+	EndTextureMode();
+}
+
+const Texture2D& RenderTarget::GetTexture() const
+{
+	return texture.texture;
+}
+
+Rectangle RenderTarget::GetSourceRect() const
+{
+	return {0.0f, (float)(texture.texture.height - height), (float)width, -(float)height};
+}
+
+int RenderTarget::GetWidth() const
+{
+	return width;
+}
+
+int RenderTarget::GetHeight() const
+{
+	return height;
+}
+
+int RenderTarget::GetCapacityWidth() const
+{
+	return texture.texture.width;
+}
+
+int RenderTarget::GetCapacityHeight() const
+{
+	return texture.texture.height;
+}
+
+int RenderTarget::GetAllocationCount()
+{
+	return allocationCount;
+}
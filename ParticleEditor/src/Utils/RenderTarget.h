@@ -0,0 +1,41 @@
+#pragma once
+
+#include <raylib.h>
+
+// Render texture that is only reallocated when the requested size outgrows it
+// or shrinks far below it. Drawing goes to the top left width x height corner,
+// GetSourceRect() is the matching (flipped) rectangle for DrawTexturePro.
+class RenderTarget
+{
+public:
+	// Extra room allocated on growth, so a drag resize doesn't reallocate every frame
+	static constexpr float SLACK = 1.25f;
+	// Reallocate smaller once the used area falls under this fraction of the capacity
+	static constexpr float SHRINK_THRESHOLD = 0.25f;
+
+	RenderTarget();
+
+	// Returns true if the texture was reallocated
+	bool Resize(int width, int height);
+	void Unload();
+
+	// Like BeginTextureMode/EndTextureMode, but limited to the used area
+	void Begin();
+	void End();
+
+	const Texture2D& GetTexture() const;
+	Rectangle GetSourceRect() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetCapacityWidth() const;
+	int GetCapacityHeight() const;
+
+	// Texture allocations of all render targets since startup
+	static int GetAllocationCount();
+
+private:
+	RenderTexture2D texture = {};
+	bool loaded = false;
+	int width = 0;
+	int height = 0;
+};
@@ -0,0 +1,272 @@
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// x / 255 rounded down, exact for everything a blend can produce
+static inline unsigned Divide255(unsigned x)
+{
+	return (x + 1 + (x >> 8)) >> 8;
+}
+
+// destination = color * a + destination * (1 - a) on every channel, alpha included,
+// which is what glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) does on an 8 bit target.
+// Premultiplied adds a instead of a * a to the alpha, so it ends up as the coverage.
+static void BlendSpan(Color* destination, int count, Color color, bool premultiplied)
+{
+	unsigned a = color.a;
+	unsigned inverse = 255 - a;
+	unsigned r = color.r * a + 127;
+	unsigned g = color.g * a + 127;
+	unsigned b = color.b * a + 127;
+	unsigned alpha = (premultiplied ? 255 : a) * a + 127;
+
+	int i = 0;
+#if defined(__SSE2__)
+	// 4 pixels at a time as 16 bit lanes, the same arithmetic as the scalar loop
+	__m128i source = _mm_setr_epi16((short)r, (short)g, (short)b, (short)alpha, (short)r, (short)g, (short)b, (short)alpha);
+	__m128i factor = _mm_set1_epi16((short)inverse);
+	__m128i one = _mm_set1_epi16(1);
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(destination + i));
+		__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), factor), source);
+		__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), factor), source);
+		low = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(low, one), _mm_srli_epi16(low, 8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(high, one), _mm_srli_epi16(high, 8)), 8);
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		Color& pixel = destination[i];
+		pixel.r = (unsigned char)Divide255(pixel.r * inverse + r);
+		pixel.g = (unsigned char)Divide255(pixel.g * inverse + g);
+		pixel.b = (unsigned char)Divide255(pixel.b * inverse + b);
+		pixel.a = (unsigned char)Divide255(pixel.a * inverse + alpha);
+	}
+}
+
+// Narrows [*low, *high) to the t where -half <= coefficient * t + offset < half
+static void Clip(float coefficient, float inverse, float offset, float half, float* low, float* high)
+{
+	if (coefficient == 0.0f)
+	{
+		if (offset < -half || offset >= half)
+			*high = -INFINITY;
+		return;
+	}
+
+	float a = (-half - offset) * inverse;
+	float b = (half - offset) * inverse;
+	if (coefficient < 0.0f)
+		std::swap(a, b);
+	*low = std::max(*low, a);
+	*high = std::min(*high, b);
+}
+
+void SoftwareRasterizer::Resize(int _width, int _height)
+{
+	_width = std::max(_width, 1);
+	_height = std::max(_height, 1);
+	if (_width == width && _height == height)
+		return;
+
+	width = _width;
+	height = _height;
+	tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	pixels.resize((size_t)width * height);
+	bins.clear();
+}
+
+void SoftwareRasterizer::Begin(Color _background, bool _premultiplied, float _scale)
+{
+	background = _background;
+	premultiplied = _premultiplied;
+	scale = _scale;
+	instances.clear();
+}
+
+void SoftwareRasterizer::Add(const ParticleSystem& system, const EmitterSettings& settings, float alpha)
+{
+	size_t first = instances.size();
+	size_t offset = first;
+	instances.resize(offset + system.GetBlockCount() * ParticlePool::BLOCK_SIZE);
+	for (size_t b = 0; b < system.GetBlockCount(); b++)
+		offset += system.GetInstances(b, settings, alpha, instances.data() + offset);
+	instances.resize(offset);
+	Scale(first);
+}
+
+void SoftwareRasterizer::Add(const ParticleInstance* _instances, size_t count)
+{
+	instances.insert(instances.end(), _instances, _instances + count);
+	Scale(instances.size() - count);
+}
+
+void SoftwareRasterizer::Scale(size_t first)
+{
+	if (scale == 1.0f)
+		return;
+
+	for (size_t i = first; i < instances.size(); i++)
+	{
+		ParticleInstance& instance = instances[i];
+		instance.x *= scale;
+		instance.y *= scale;
+		instance.width *= scale;
+		instance.height *= scale;
+	}
+}
+
+void SoftwareRasterizer::End(JobSystem* jobs)
+{
+	size_t tileCount = (size_t)tilesX * tilesY;
+	chunkCount = (instances.size() + BIN_CHUNK - 1) / BIN_CHUNK;
+	quads.resize(instances.size());
+	if (bins.size() < chunkCount * tileCount)
+		bins.resize(chunkCount * tileCount);
+
+	auto bin = [this](size_t begin, size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+			Bin(chunk);
+	};
+	auto shade = [this](size_t begin, size_t end)
+	{
+		for (size_t tile = begin; tile < end; tile++)
+			ShadeTile(tile);
+	};
+
+	if (jobs)
+	{
+		jobs->ParallelFor(chunkCount, 1, bin);
+		jobs->ParallelFor(tileCount, 1, shade);
+	}
+	else
+	{
+		bin(0, chunkCount);
+		shade(0, tileCount);
+	}
+
+	binnedCount = 0;
+	for (size_t i = 0; i < chunkCount * tileCount; i++)
+		binnedCount += bins[i].size();
+}
+
+void SoftwareRasterizer::Bin(size_t chunk)
+{
+	size_t tileCount = (size_t)tilesX * tilesY;
+	std::vector<uint32_t>* chunkBins = &bins[chunk * tileCount];
+	for (size_t tile = 0; tile < tileCount; tile++)
+		chunkBins[tile].clear();
+
+	size_t end = std::min(instances.size(), (chunk + 1) * BIN_CHUNK);
+	for (size_t i = chunk * BIN_CHUNK; i < end; i++)
+	{
+		// Zero or negative sizes are culled by the GPU as well
+		const ParticleInstance& instance = instances[i];
+		if (instance.color.a == 0 || !(instance.width > 0.0f) || !(instance.height > 0.0f))
+			continue;
+
+		// Worked out once here instead of in every tile the quad touches
+		Quad& quad = quads[i];
+		float angle = instance.rotation * DEG2RAD;
+		quad.cosine = std::cos(angle);
+		quad.sine = std::sin(angle);
+		quad.inverseCosine = 1.0f / quad.cosine;
+		quad.inverseSine = 1.0f / quad.sine;
+		quad.halfWidth = instance.width / 2.0f;
+		quad.halfHeight = instance.height / 2.0f;
+		float extentX = std::fabs(quad.cosine) * quad.halfWidth + std::fabs(quad.sine) * quad.halfHeight;
+		quad.extentY = std::fabs(quad.sine) * quad.halfWidth + std::fabs(quad.cosine) * quad.halfHeight;
+
+		float left = instance.x - extentX;
+		float right = instance.x + extentX;
+		float top = instance.y - quad.extentY;
+		float bottom = instance.y + quad.extentY;
+		// Also false for NaN
+		if (!(right > 0.0f && left < width && bottom > 0.0f && top < height))
+			continue;
+
+		int firstX = (int)std::max(left, 0.0f) / TILE_SIZE;
+		int lastX = (int)std::min(right, width - 1.0f) / TILE_SIZE;
+		int firstY = (int)std::max(top, 0.0f) / TILE_SIZE;
+		int lastY = (int)std::min(bottom, height - 1.0f) / TILE_SIZE;
+		for (int y = firstY; y <= lastY; y++)
+		{
+			for (int x = firstX; x <= lastX; x++)
+				chunkBins[y * tilesX + x].push_back((uint32_t)i);
+		}
+	}
+}
+
+void SoftwareRasterizer::ShadeTile(size_t tile)
+{
+	int x0 = (int)(tile % tilesX) * TILE_SIZE;
+	int y0 = (int)(tile / tilesX) * TILE_SIZE;
+	int x1 = std::min(x0 + TILE_SIZE, width);
+	int y1 = std::min(y0 + TILE_SIZE, height);
+
+	for (int y = y0; y < y1; y++)
+		std::fill(&pixels[(size_t)y * width + x0], &pixels[(size_t)y * width + x1], background);
+
+	size_t tileCount = (size_t)tilesX * tilesY;
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		for (uint32_t index : bins[chunk * tileCount + tile])
+		{
+			const ParticleInstance& instance = instances[index];
+			const Quad& quad = quads[index];
+			int firstRow = (int)std::floor(std::max(instance.y - quad.extentY, (float)y0));
+			int endRow = (int)std::ceil(std::min(instance.y + quad.extentY, (float)y1));
+			for (int y = firstRow; y < endRow; y++)
+			{
+				// Pixel centers inside the quad, solved per row from its local axes
+				float dy = y + 0.5f - instance.y;
+				float low = -INFINITY;
+				float high = INFINITY;
+				Clip(quad.cosine, quad.inverseCosine, dy * quad.sine, quad.halfWidth, &low, &high);
+				Clip(-quad.sine, -quad.inverseSine, dy * quad.cosine, quad.halfHeight, &low, &high);
+
+				// Clamped to the tile before converting, the bounds can be huge for nearly axis aligned quads
+				float left = std::max(low + instance.x - 0.5f, (float)x0);
+				float right = std::min(high + instance.x - 0.5f, (float)x1);
+				if (!(right > left))
+					continue;
+
+				int first = (int)std::ceil(left);
+				int end = (int)std::ceil(right);
+				if (end > first)
+					BlendSpan(&pixels[(size_t)y * width + first], end - first, instance.color, premultiplied);
+			}
+		}
+	}
+}
+
+const Color* SoftwareRasterizer::GetPixels() const
+{
+	return pixels.data();
+}
+
+int SoftwareRasterizer::GetWidth() const
+{
+	return width;
+}
+
+int SoftwareRasterizer::GetHeight() const
+{
+	return height;
+}
+
+size_t SoftwareRasterizer::GetBinnedCount() const
+{
+	return binnedCount;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Simulation/ParticleSystem.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Draws particle systems into an RGBA buffer on the CPU, for machines without
+// a GPU. Same layout as the viewport: row 0 is the top and particles are
+// rotated quads blended in order like raylib's BLEND_ALPHA. Instances are
+// binned into TILE_SIZE squares, then every tile is shaded on its own, so with
+// a JobSystem both steps run on its workers. The result doesn't depend on the
+// worker count.
+class SoftwareRasterizer
+{
+public:
+	static constexpr int TILE_SIZE = 64;
+	// Instances binned by one job
+	static constexpr size_t BIN_CHUNK = 4096;
+
+	void Resize(int width, int height);
+
+	// Same use as ParticleRenderer, Begin clears to background. Premultiplied
+	// output has the color multiplied by the alpha, so drawing it with
+	// (GL_ONE, GL_ONE_MINUS_SRC_ALPHA) over anything matches drawing the particles there.
+	// Positions and sizes are multiplied by scale, to draw at a lower resolution.
+	void Begin(Color background, bool premultiplied = false, float scale = 1.0f);
+	void Add(const ParticleSystem& system, const EmitterSettings& settings, float alpha);
+	void Add(const ParticleInstance* instances, size_t count);
+	void End(JobSystem* jobs = nullptr);
+
+	// width * height pixels, row by row from the top
+	const Color* GetPixels() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	// Instance and tile pairs of the last End, an instance touching 4 tiles counts 4 times
+	size_t GetBinnedCount() const;
+
+private:
+	// Per instance setup shared by every tile it touches, written while binning
+	struct Quad
+	{
+		float cosine;
+		float sine;
+		float inverseCosine;
+		float inverseSine;
+		float halfWidth;
+		float halfHeight;
+		float extentY;
+	};
+
+	// Applies scale to the instances added since first
+	void Scale(size_t first);
+	void Bin(size_t chunk);
+	void ShadeTile(size_t tile);
+
+	int width = 0;
+	int height = 0;
+	int tilesX = 0;
+	int tilesY = 0;
+	std::vector<Color> pixels;
+	// Filled in by each tile before drawing its particles
+	Color background = WHITE;
+	bool premultiplied = false;
+	float scale = 1.0f;
+	std::vector<ParticleInstance> instances;
+	std::vector<Quad> quads;
+	// bins[chunk * tileCount + tile] holds the chunk's instances touching the tile, in drawing order
+	std::vector<std::vector<uint32_t>> bins;
+	size_t chunkCount = 0;
+	size_t binnedCount = 0;
+};
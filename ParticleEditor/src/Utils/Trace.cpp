@@ -0,0 +1,179 @@
+#include "Trace.h"
+
+#include <Difu/Utils/Logger.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fmt/core.h>
+
+namespace Trace
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// Only the owning thread writes events and state, so a new capture can't
+	// reset the count under a write in progress. The owner resets it itself when
+	// state still holds an older capture's generation.
+	struct ThreadBuffer
+	{
+		// Set once by Start and never freed, the owner reads it without the lock
+		std::atomic<Event*> events = nullptr;
+		std::unique_ptr<Event[]> storage;
+		// Capture generation in the high 32 bits, event count in the low ones
+		std::atomic<uint64_t> state = 0;
+		int id = 0;
+		std::string name;
+	};
+
+	std::atomic<bool> Detail::recording = false;
+
+	// Buffers outlive their threads so a trace can still be saved after a worker exits
+	static std::mutex buffersMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	static thread_local ThreadBuffer* threadBuffer = nullptr;
+	static std::atomic<size_t> dropped = 0;
+	static std::atomic<uint32_t> generation = 0;
+	static uint64_t startTime = 0;
+
+	static ThreadBuffer* GetThreadBuffer()
+	{
+		if (!threadBuffer)
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffers.push_back(std::make_unique<ThreadBuffer>());
+			threadBuffer = buffers.back().get();
+			threadBuffer->id = (int)buffers.size();
+			threadBuffer->name = fmt::format("Thread {}", threadBuffer->id);
+		}
+		return threadBuffer;
+	}
+
+	// Events recorded in the current capture, for threads other than the owner
+	static size_t GetCount(const ThreadBuffer& buffer)
+	{
+		uint64_t state = buffer.state.load(std::memory_order_acquire);
+		if ((uint32_t)(state >> 32) != generation.load(std::memory_order_relaxed))
+			return 0;
+		return (size_t)(state & 0xffffffff);
+	}
+
+	uint64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Start()
+	{
+		if (IsRecording())
+			return;
+
+		GetThreadBuffer();
+		{
+			// Every registered thread gets its buffer here rather than in its first scope
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			for (std::unique_ptr<ThreadBuffer>& buffer : buffers)
+			{
+				if (buffer->storage)
+					continue;
+				buffer->storage = std::make_unique<Event[]>(EVENTS_PER_THREAD);
+				buffer->events.store(buffer->storage.get(), std::memory_order_relaxed);
+			}
+		}
+		dropped = 0;
+		startTime = Now();
+		// Older counts become stale, the release below publishes this and the buffers to Record
+		generation.fetch_add(1, std::memory_order_relaxed);
+		Detail::recording.store(true, std::memory_order_release);
+	}
+
+	bool Stop(const std::string& filename)
+	{
+		if (!IsRecording())
+			return false;
+		Detail::recording.store(false, std::memory_order_release);
+
+		std::FILE* file = std::fopen(filename.c_str(), "w");
+		if (!file)
+		{
+			Logger::Error("Could not write trace {}: {}", filename, std::strerror(errno));
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		size_t total = 0;
+		fmt::print(file, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+		for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+		{
+			fmt::print(file, "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", first ? "" : ",\n", buffer->id, buffer->name);
+			first = false;
+
+			size_t count = GetCount(*buffer);
+			const Event* events = buffer->events.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < count; i++)
+			{
+				const Event& event = events[i];
+				// A scope that began before Start and ended after it
+				if (event.start < startTime)
+					continue;
+				// Chrome traces are in microseconds
+				fmt::print(file, ",\n{{\"name\":\"{}\",\"cat\":\"editor\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+					event.name, buffer->id, (event.start - startTime) / 1000.0, (event.end - event.start) / 1000.0);
+				total++;
+			}
+		}
+		fmt::print(file, "\n]}}\n");
+		std::fclose(file);
+
+		if (dropped > 0)
+			LOG_WARN("{} trace events were dropped, their buffer was full or their thread registered after Start", dropped.load());
+		LOG_INFO("Saved {} trace events to {}", total, filename);
+		return true;
+	}
+
+	size_t GetEventCount()
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		size_t total = 0;
+		for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+			total += GetCount(*buffer);
+		return total;
+	}
+
+	void SetThreadName(const char* name)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer->name = name;
+	}
+
+	void Record(const char* name, uint64_t start, uint64_t end)
+	{
+		// Pairs with the release in Start, so the generation and buffers set before it are visible
+		if (!Detail::recording.load(std::memory_order_acquire))
+			return;
+
+		ThreadBuffer* buffer = GetThreadBuffer();
+		Event* events = buffer->events.load(std::memory_order_relaxed);
+		uint32_t current = generation.load(std::memory_order_relaxed);
+		uint64_t state = buffer->state.load(std::memory_order_relaxed);
+		size_t index = (uint32_t)(state >> 32) == current ? (size_t)(state & 0xffffffff) : 0;
+		if (!events || index >= EVENTS_PER_THREAD)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		events[index] = {name, start, end};
+		buffer->state.store((uint64_t)current << 32 | (index + 1), std::memory_order_release);
+	}
+}
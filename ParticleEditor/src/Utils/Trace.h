@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Records scopes into per-thread preallocated buffers and saves them as a
+// Chrome Trace Event file, which chrome://tracing and Perfetto can open.
+// When not recording a scope costs one relaxed atomic load.
+namespace Trace
+{
+	// Events kept per thread, later ones are dropped
+	constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+	namespace Detail
+	{
+		extern std::atomic<bool> recording;
+	}
+
+	void Start();
+	// Stops recording and writes everything recorded since Start
+	bool Stop(const std::string& filename);
+	size_t GetEventCount();
+
+	inline bool IsRecording()
+	{
+		return Detail::recording.load(std::memory_order_relaxed);
+	}
+
+	// Shown as the thread name in the trace viewer. Also registers the thread,
+	// Start only gives buffers to registered threads, so call it before Start.
+	// A thread that registers with its first scope during a capture has its
+	// events counted as dropped until the next one.
+	void SetThreadName(const char* name);
+
+	uint64_t Now();
+	// name must outlive the recording, in practice a string literal
+	void Record(const char* name, uint64_t start, uint64_t end);
+
+	class Scope
+	{
+	public:
+		explicit Scope(const char* _name) : name(_name), start(IsRecording() ? Now() : 0) {}
+		~Scope()
+		{
+			if (start != 0)
+				Record(name, start, Now());
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		const char* name;
+		uint64_t start;
+	};
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
@@ -0,0 +1,280 @@
+#include "SelfTest.h"
+
+#include "Simulation/CheckpointTimeline.h"
+#include "Simulation/FixedTimestep.h"
+#include "Simulation/ParticleScene.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <fmt/core.h>
+
+namespace fs = std::filesystem;
+
+namespace SelfTest
+{
+	static int checks = 0;
+	static int failures = 0;
+
+	static void Check(bool ok, const std::string& what)
+	{
+		checks++;
+		if (!ok)
+		{
+			failures++;
+			fmt::print(stderr, "FAIL {}\n", what);
+		}
+	}
+
+	static std::vector<unsigned char> Repeat(unsigned char value, size_t count)
+	{
+		return std::vector<unsigned char>(count, value);
+	}
+
+	// No two neighbours equal, so the encoder can only emit literals
+	static std::vector<unsigned char> Distinct(size_t count)
+	{
+		std::vector<unsigned char> bytes(count);
+		for (size_t i = 0; i < count; i++)
+			bytes[i] = (unsigned char)(i * 7 + 1);
+		return bytes;
+	}
+
+	static std::vector<unsigned char> Join(std::vector<unsigned char> a, const std::vector<unsigned char>& b)
+	{
+		a.insert(a.end(), b.begin(), b.end());
+		return a;
+	}
+
+	static void CheckCompress(const std::vector<unsigned char>& input, const std::string& what)
+	{
+		std::vector<unsigned char> compressed;
+		std::vector<unsigned char> output;
+		CheckpointTimeline::Compress(input, &compressed);
+		Check(CheckpointTimeline::Decompress(compressed, &output) && output == input, "checkpoint codec round trip, " + what);
+
+		// A cut off snapshot has to be rejected rather than restored short
+		if (compressed.size() > 4)
+		{
+			compressed.pop_back();
+			Check(!CheckpointTimeline::Decompress(compressed, &output), "checkpoint codec rejects truncation, " + what);
+		}
+	}
+
+	static void CheckCodec()
+	{
+		CheckCompress({}, "empty");
+		CheckCompress({42}, "1 byte");
+
+		// Runs are 3 to 130 bytes long, longer ones continue in a second run or a literal
+		for (size_t run : {2, 3, 4, 129, 130, 131, 132, 133, 260, 261})
+			CheckCompress(Repeat(0, run), fmt::format("run of {}", run));
+		// Literals hold at most 128 bytes
+		for (size_t literal : {127, 128, 129, 256, 257})
+			CheckCompress(Distinct(literal), fmt::format("literal of {}", literal));
+
+		CheckCompress(Join(Distinct(128), Repeat(5, 3)), "literal of 128 then run of 3");
+		CheckCompress(Join(Repeat(5, 130), Distinct(129)), "run of 130 then literal of 129");
+		CheckCompress(Join(Join(Distinct(10), Repeat(9, 2)), Distinct(10)), "pair inside literals");
+
+		// Fixed seed, so a failure reproduces
+		uint32_t random = 12345;
+		std::vector<unsigned char> noise(10000);
+		for (unsigned char& value : noise)
+		{
+			random = random * 1664525u + 1013904223u;
+			// Small values give a mix of short runs and literals
+			value = (unsigned char)((random >> 24) % 3);
+		}
+		CheckCompress(noise, "10000 mixed bytes");
+
+		std::vector<uint32_t> words = {0, 0, 1, 0xffffffffu, 0x3f800000u, 0x3f800001u, 0};
+		std::vector<unsigned char> planes;
+		std::vector<uint32_t> restored;
+		CheckpointTimeline::Shuffle(words, &planes);
+		CheckpointTimeline::Unshuffle(planes, &restored);
+		Check(restored == words, "checkpoint shuffle round trip");
+		CheckpointTimeline::Shuffle({}, &planes);
+		CheckpointTimeline::Unshuffle(planes, &restored);
+		Check(restored.empty(), "checkpoint shuffle round trip, empty");
+	}
+
+	// Steps a scene of every emitter, restores each checkpoint and compares it with the hash taken when it was recorded
+	static void CheckScene(const std::vector<ParticleSerializer::BankEmitter>& emitters, ParticleLayout layout, const char* layoutName)
+	{
+		const float dt = FixedTimestep::DEFAULT_STEP;
+		ParticleScene scene;
+		scene.SetLayout(layout);
+		std::vector<ParticleEmitter> bound;
+		std::vector<EmitterSettings> settings(emitters.size());
+		for (size_t i = 0; i < emitters.size(); i++)
+		{
+			scene.Add();
+			bound.push_back(emitters[i].emitter);
+		}
+		scene.Reset(1);
+
+		CheckpointTimeline timeline;
+		std::vector<double> times;
+		std::vector<uint64_t> hashes;
+		for (int step = 0; step <= (int)(3.0f / dt); step++)
+		{
+			timeline.Record(scene);
+			if (timeline.GetCount() > times.size())
+			{
+				times.push_back(scene.GetTime());
+				hashes.push_back(scene.GetStateHash());
+			}
+
+			for (size_t i = 0; i < emitters.size(); i++)
+			{
+				emitters[i].extras.bindings.Apply(&bound[i], (float)scene.GetTime());
+				settings[i] = EmitterSettings::FromEmitter(bound[i], {i * 100.0f, 0.0f});
+			}
+			scene.Step(settings.data(), dt);
+		}
+
+		// The first checkpoint is the empty scene at time 0
+		Check(times.size() > 1, fmt::format("checkpoints recorded, {}", layoutName));
+		for (size_t i = 0; i < times.size(); i++)
+		{
+			bool restored = timeline.Restore(times[i], &scene);
+			Check(restored && scene.GetTime() == times[i] && scene.GetStateHash() == hashes[i],
+				fmt::format("checkpoint restore at {:.2f} s, {}", times[i], layoutName));
+		}
+	}
+
+	// Hash of the canonical binary record, the same as the fingerprint command prints
+	static bool Fingerprint(const std::string& name, const ParticleEmitter& emitter, const EmitterExtras& extras, uint64_t* hash)
+	{
+		unsigned char record[ParticleSerializer::BINARY_MAX_SIZE];
+		size_t size = ParticleSerializer::EncodeBinary(record, name, emitter, &extras);
+		*hash = EmitterBank::Hash(std::string_view((const char*)record, size));
+		return size > 0;
+	}
+
+	// The record could cut or drop an expression the same way on both sides, so the sources are compared too
+	static bool SameBindings(const EmitterExtras& a, const EmitterExtras& b)
+	{
+		for (int i = 0; i < PropertyBindings::COUNT; i++)
+		{
+			BindingTarget target = (BindingTarget)i;
+			if (a.bindings.IsBound(target) != b.bindings.IsBound(target))
+				return false;
+			if (a.bindings.IsBound(target) && a.bindings.GetExpression(target).GetSource() != b.bindings.GetExpression(target).GetSource())
+				return false;
+		}
+		return true;
+	}
+
+	static void CheckFormats(const ParticleSerializer::BankEmitter& entry, const fs::path& directory)
+	{
+		uint64_t expected;
+		if (!Fingerprint(entry.name, entry.emitter, entry.extras, &expected))
+		{
+			Check(false, "binary encode, " + entry.name);
+			return;
+		}
+
+		ParticleEmitter emitter;
+		std::string name;
+		EmitterExtras extras;
+		uint64_t hash = 0;
+
+		unsigned char record[ParticleSerializer::BINARY_MAX_SIZE];
+		size_t size = ParticleSerializer::EncodeBinary(record, entry.name, entry.emitter, &entry.extras);
+		bool ok = ParticleSerializer::DecodeBinary(record, size, &emitter, &name, &extras) && Fingerprint(name, emitter, extras, &hash);
+		Check(ok && hash == expected && SameBindings(extras, entry.extras), "binary record round trip, " + entry.name);
+
+		fs::path text = directory / "emitter.txt";
+		ok = ParticleSerializer::Serialize(text.string(), entry.name, entry.emitter, &entry.extras)
+			&& ParticleSerializer::Deserialize(text.string(), &emitter, &name, &extras) && Fingerprint(name, emitter, extras, &hash);
+		Check(ok && hash == expected && SameBindings(extras, entry.extras) && name == entry.name, "text round trip, " + entry.name);
+
+		// Binary files cut the name to BINARY_NAME_SIZE - 1, as does the record the fingerprint hashes
+		fs::path binary = directory / "emitter.pbin";
+		fs::path back = directory / "back.txt";
+		ok = ParticleSerializer::ConvertTextToBinary(text.string(), binary.string()) && ParticleSerializer::ConvertBinaryToText(binary.string(), back.string())
+			&& ParticleSerializer::Deserialize(back.string(), &emitter, &name, &extras) && Fingerprint(name, emitter, extras, &hash);
+		Check(ok && hash == expected && SameBindings(extras, entry.extras), "text to binary to text, " + entry.name);
+	}
+
+	static void CheckBank(const std::vector<ParticleSerializer::BankEmitter>& entries, const fs::path& directory)
+	{
+		fs::path file = directory / "emitters.pbank";
+		EmitterBank bank;
+		bool ok = ParticleSerializer::SerializeBank(file.string(), entries) && ParticleSerializer::OpenBank(file.string(), &bank);
+		Check(ok && bank.GetCount() == entries.size(), "bank pack and open");
+		if (!ok)
+			return;
+
+		// Looked up by the full name, the index keeps it even where the record's copy is cut
+		for (const ParticleSerializer::BankEmitter& entry : entries)
+		{
+			ParticleEmitter emitter;
+			EmitterExtras extras;
+			uint64_t expected = 0;
+			uint64_t hash = 1;
+			ok = ParticleSerializer::DeserializeFromBank(bank, entry.name, &emitter, &extras)
+				&& Fingerprint(entry.name, entry.emitter, entry.extras, &expected) && Fingerprint(entry.name, emitter, extras, &hash);
+			Check(ok && hash == expected && SameBindings(extras, entry.extras), "bank lookup, " + entry.name);
+		}
+	}
+
+	static void CheckSerializer(const std::vector<ParticleSerializer::BankEmitter>& emitters)
+	{
+		fs::path directory = fs::temp_directory_path() / "ParticleToolSelfTest";
+		std::error_code error;
+		fs::create_directories(directory, error);
+
+		// Bank names have to be unique
+		std::vector<ParticleSerializer::BankEmitter> entries;
+		std::set<std::string> names;
+		for (const ParticleSerializer::BankEmitter& emitter : emitters)
+		{
+			entries.push_back(emitter);
+			while (!names.insert(entries.back().name).second)
+				entries.back().name += " copy";
+		}
+
+		// The longest expression both formats hold, one more character is refused when binding
+		ParticleSerializer::BankEmitter limit = emitters.front();
+		std::string source = "t * 1.";
+		source.resize(ParticleSerializer::BINARY_MAX_EXPRESSION, '0');
+		std::string bindError;
+		Check(limit.extras.bindings.Bind(BindingTarget::VelocityX, source, &bindError), "bind expression of BINARY_MAX_EXPRESSION characters: " + bindError);
+		EmitterExtras longer;
+		Check(!longer.bindings.Bind(BindingTarget::VelocityX, source + "0"), "refuse expression longer than BINARY_MAX_EXPRESSION");
+		limit.name = "selftest expression at the limit";
+		entries.push_back(limit);
+
+		// Two names that only differ after the cut, with different records
+		ParticleSerializer::BankEmitter longName = emitters.front();
+		longName.name = "selftest name longer than the binary record holds, the bank index keeps all of it";
+		ParticleSerializer::BankEmitter cutName = limit;
+		cutName.name = longName.name.substr(0, ParticleSerializer::BINARY_NAME_SIZE - 1);
+		entries.push_back(longName);
+		entries.push_back(cutName);
+
+		for (const ParticleSerializer::BankEmitter& entry : entries)
+			CheckFormats(entry, directory);
+		CheckBank(entries, directory);
+
+		fs::remove_all(directory, error);
+	}
+
+	int Run(const std::vector<ParticleSerializer::BankEmitter>& emitters)
+	{
+		checks = 0;
+		failures = 0;
+
+		CheckCodec();
+		CheckScene(emitters, ParticleLayout::ArrayOfStructs, "array of structs");
+		CheckScene(emitters, ParticleLayout::StructOfArrays, "struct of arrays");
+		CheckSerializer(emitters);
+
+		fmt::print("{} checks, {} failed\n", checks, failures);
+		return failures;
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Utils/ParticleSerializer.h"
+
+#include <vector>
+
+// Round trip checks for the formats and codecs that have to be exact, run by
+// "ParticleTool selftest" on the given emitters. Every failed check is printed
+// to stderr, the tool exits with 1 if there was any.
+namespace SelfTest
+{
+	// Returns the number of failed checks
+	int Run(const std::vector<ParticleSerializer::BankEmitter>& emitters);
+}
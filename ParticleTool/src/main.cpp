@@ -0,0 +1,540 @@
+#include "Utils/ParticleSerializer.h"
+#include "Utils/EmitterBank.h"
+#include "Simulation/ParticleSystem.h"
+#include "Simulation/FixedTimestep.h"
+#include "Utils/JobSystem.h"
+#include "Utils/SoftwareRasterizer.h"
+#include "Utils/FlipbookBaker.h"
+#include "SelfTest.h"
+
+#include <Difu/Utils/Logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+
+namespace fs = std::filesystem;
+
+// Seconds simulated by the state command, set with -t
+static float simulateSeconds = 5.0f;
+// Size of the images written by the render command, set with -s
+static int renderWidth = 800;
+static int renderHeight = 600;
+// Frames in each sheet written by the bake command, set with -f
+static int bakeFrames = 32;
+// The render and bake commands draw one file at a time with tiles or frames spread over these
+static JobSystem renderJobs;
+
+// Logger output of the file being processed on this thread, printed in input order once all workers are done
+static thread_local std::string* capturedLog = nullptr;
+
+static void CaptureLog(std::string value)
+{
+	if (capturedLog)
+	{
+		capturedLog->append(value);
+		capturedLog->push_back('\n');
+	}
+	else
+		fmt::print(stderr, "{}\n", value);
+}
+
+struct FileResult
+{
+	bool ok = false;
+	std::string output;
+	std::string log;
+};
+
+using Command = std::function<bool(const fs::path& file, std::string* output)>;
+
+static bool IsBinary(const fs::path& file)
+{
+	return file.extension() == ".pbin";
+}
+
+static bool IsBank(const fs::path& file)
+{
+	return file.extension() == ".pbank";
+}
+
+static bool IsEmitterFile(const fs::path& file)
+{
+	fs::path extension = file.extension();
+	return extension == ".txt" || extension == ".save" || extension == ".pbin" || extension == ".pbank";
+}
+
+// Text emitters are a name line followed by a '{' line, so notes and READMEs in a directory are left alone
+static bool LooksLikeTextEmitter(const fs::path& file)
+{
+	std::ifstream in(file);
+	std::string line;
+	if (!std::getline(in, line))
+		return false;
+	while (std::getline(in, line))
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first != std::string::npos)
+			return line[first] == '{';
+	}
+	return false;
+}
+
+static bool Load(const fs::path& file, ParticleEmitter* emitter, std::string* name, EmitterExtras* extras)
+{
+	if (IsBank(file))
+	{
+		Logger::Error("{} is an emitter bank, this command takes single emitter files", file.string());
+		return false;
+	}
+	if (IsBinary(file))
+		return ParticleSerializer::DeserializeBinary(file.string(), emitter, name, extras);
+	return ParticleSerializer::Deserialize(file.string(), emitter, name, extras);
+}
+
+static bool Validate(const fs::path& file, std::string* output)
+{
+	if (IsBank(file))
+	{
+		EmitterBank bank;
+		if (!bank.Open(file.string()))
+			return false;
+
+		for (size_t i = 0; i < bank.GetCount(); i++)
+		{
+			size_t size = 0;
+			const unsigned char* record = bank.GetRecord(i, &size);
+			ParticleEmitter emitter;
+			EmitterExtras extras;
+			if (!ParticleSerializer::DecodeBinary(record, size, &emitter, nullptr, &extras))
+				return false;
+		}
+		*output = fmt::format("ok ({} emitters)", bank.GetCount());
+		return true;
+	}
+
+	ParticleEmitter emitter;
+	std::string name;
+	EmitterExtras extras;
+	if (!Load(file, &emitter, &name, &extras))
+		return false;
+
+	*output = "ok";
+	return true;
+}
+
+static fs::path GetConvertTarget(const fs::path& file)
+{
+	fs::path target = file;
+	target.replace_extension(IsBinary(file) ? ".txt" : ".pbin");
+	return target;
+}
+
+static bool Convert(const fs::path& file, std::string* output)
+{
+	if (IsBank(file))
+	{
+		Logger::Error("{} is an emitter bank, only single emitter files can be converted", file.string());
+		return false;
+	}
+
+	fs::path target = GetConvertTarget(file);
+	bool ok;
+	if (IsBinary(file))
+		ok = ParticleSerializer::ConvertBinaryToText(file.string(), target.string());
+	else
+		ok = ParticleSerializer::ConvertTextToBinary(file.string(), target.string());
+
+	*output = target.string();
+	return ok;
+}
+
+static bool Normalize(const fs::path& file, std::string* output)
+{
+	ParticleEmitter emitter;
+	std::string name;
+	EmitterExtras extras;
+	if (!Load(file, &emitter, &name, &extras))
+		return false;
+
+	*output = "normalized";
+	if (IsBinary(file))
+		return ParticleSerializer::SerializeBinary(file.string(), name, emitter, &extras);
+	return ParticleSerializer::Serialize(file.string(), name, emitter, &extras);
+}
+
+static bool Fingerprint(const fs::path& file, std::string* output)
+{
+	ParticleEmitter emitter;
+	std::string name;
+	EmitterExtras extras;
+	if (!Load(file, &emitter, &name, &extras))
+		return false;
+
+	// Hash of the canonical binary record, so a text file and its converted binary match
+	unsigned char record[ParticleSerializer::BINARY_MAX_SIZE];
+	size_t size = ParticleSerializer::EncodeBinary(record, name, emitter, &extras);
+	if (size == 0)
+		return false;
+	uint64_t hash = EmitterBank::Hash(std::string_view((const char*)record, size));
+
+	*output = fmt::format("{:016x}", hash);
+	return true;
+}
+
+// Same steps as the editor's fixed timestep mode with its default seed
+static void Simulate(ParticleEmitter* emitter, const EmitterExtras& extras, Vector2 position, ParticleSystem* simulation)
+{
+	simulation->Reset(1);
+	int steps = (int)std::lround(simulateSeconds / FixedTimestep::DEFAULT_STEP);
+	for (int i = 0; i < steps; i++)
+	{
+		extras.bindings.Apply(emitter, (float)simulation->GetTime());
+		simulation->Step(EmitterSettings::FromEmitter(*emitter, position), FixedTimestep::DEFAULT_STEP);
+	}
+}
+
+static bool State(const fs::path& file, std::string* output)
+{
+	ParticleEmitter emitter;
+	std::string name;
+	EmitterExtras extras;
+	if (!Load(file, &emitter, &name, &extras))
+		return false;
+
+	ParticleSystem simulation;
+	Simulate(&emitter, extras, {0.0f, 0.0f}, &simulation);
+
+	*output = fmt::format("{:016x} {} particles", simulation.GetStateHash(), simulation.GetCount());
+	return true;
+}
+
+static bool Render(const fs::path& file, std::string* output)
+{
+	ParticleEmitter emitter;
+	std::string name;
+	EmitterExtras extras;
+	if (!Load(file, &emitter, &name, &extras))
+		return false;
+
+	// Centered like the editor's default emitter
+	Vector2 center = {renderWidth / 2.0f, renderHeight / 2.0f};
+	ParticleSystem simulation;
+	Simulate(&emitter, extras, center, &simulation);
+
+	SoftwareRasterizer rasterizer;
+	rasterizer.Resize(renderWidth, renderHeight);
+	rasterizer.Begin(WHITE);
+	rasterizer.Add(simulation, EmitterSettings::FromEmitter(emitter, center), 1.0f);
+	rasterizer.End(&renderJobs);
+
+	fs::path target = file;
+	target.replace_extension(".png");
+	*output = target.string();
+
+	Image image = {(void*)rasterizer.GetPixels(), renderWidth, renderHeight, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+	return ExportImage(image, target.string().c_str());
+}
+
+static bool Bake(const fs::path& file, std::string* output)
+{
+	ParticleEmitter emitter;
+	std::string name;
+	EmitterExtras extras;
+	if (!Load(file, &emitter, &name, &extras))
+		return false;
+
+	FlipbookBaker::Options options;
+	options.frameWidth = renderWidth;
+	options.frameHeight = renderHeight;
+	options.frameCount = bakeFrames;
+	FlipbookBaker::Flipbook flipbook;
+	if (!FlipbookBaker::Bake(emitter, extras, options, &renderJobs, &flipbook))
+		return false;
+
+	fs::path target = file;
+	target.replace_extension(".flipbook.png");
+	*output = fmt::format("{} {}x{} {} KiB", target.string(), flipbook.GetAtlasWidth(), flipbook.GetAtlasHeight(), flipbook.GetAtlasMemory() / 1024);
+	return FlipbookBaker::Save(target.string(), flipbook);
+}
+
+// Banks found in directories are only picked up when includeBanks is set, files named directly always are
+static std::vector<fs::path> CollectFiles(const std::vector<std::string>& inputs, bool includeBanks)
+{
+	std::vector<fs::path> files;
+	for (const std::string& input : inputs)
+	{
+		std::error_code error;
+		if (fs::is_directory(input, error))
+		{
+			size_t first = files.size();
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input, error))
+			{
+				if (!entry.is_regular_file() || !IsEmitterFile(entry.path()))
+					continue;
+				if (IsBank(entry.path()) ? !includeBanks : entry.path().extension() == ".txt" && !LooksLikeTextEmitter(entry.path()))
+					continue;
+				files.push_back(entry.path());
+			}
+			// Directory iteration order is unspecified, keep output stable across runs
+			std::sort(files.begin() + first, files.end());
+		}
+		else
+			files.push_back(input);
+	}
+	return files;
+}
+
+static std::vector<FileResult> RunParallel(const std::vector<fs::path>& files, const Command& command, unsigned int threadCount)
+{
+	std::vector<FileResult> results(files.size());
+	std::atomic<size_t> next = 0;
+
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < files.size(); i = next++)
+		{
+			capturedLog = &results[i].log;
+			results[i].ok = command(files[i], &results[i].output);
+			capturedLog = nullptr;
+		}
+	};
+
+	threadCount = std::max(1u, std::min<unsigned int>(threadCount, files.size()));
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadCount; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	return results;
+}
+
+// Converting a.txt and a.pbin together, or a.txt and a.save, would have two jobs writing the same file
+static bool FindConvertCollisions(const std::vector<fs::path>& files)
+{
+	auto key = [](const fs::path& path)
+	{
+		std::error_code error;
+		fs::path absolute = fs::weakly_canonical(path, error);
+		return error ? fs::absolute(path).lexically_normal() : absolute;
+	};
+
+	std::map<fs::path, size_t> inputs;
+	for (size_t i = 0; i < files.size(); i++)
+		inputs.emplace(key(files[i]), i);
+
+	bool found = false;
+	std::map<fs::path, size_t> targets;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		fs::path target = key(GetConvertTarget(files[i]));
+		std::map<fs::path, size_t>::const_iterator input = inputs.find(target);
+		if (input != inputs.end())
+		{
+			fmt::print(stderr, "{} would overwrite {}, which is also an input\n", files[i].string(), files[input->second].string());
+			found = true;
+		}
+
+		std::pair<std::map<fs::path, size_t>::iterator, bool> inserted = targets.emplace(target, i);
+		if (!inserted.second)
+		{
+			fmt::print(stderr, "{} and {} would both be converted to {}\n", files[inserted.first->second].string(), files[i].string(), target.string());
+			found = true;
+		}
+	}
+	return found;
+}
+
+// Unnamed emitters are named after their file
+static bool LoadAll(const std::vector<fs::path>& files, std::vector<ParticleSerializer::BankEmitter>* emitters)
+{
+	emitters->resize(files.size());
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		ParticleSerializer::BankEmitter& entry = (*emitters)[i];
+		std::string log;
+		capturedLog = &log;
+		bool loaded = Load(files[i], &entry.emitter, &entry.name, &entry.extras);
+		capturedLog = nullptr;
+
+		if (!loaded)
+		{
+			fmt::print(stderr, "FAIL {}\n{}", files[i].string(), log);
+			return false;
+		}
+		if (entry.name.empty())
+			entry.name = files[i].stem().string();
+	}
+	return true;
+}
+
+static bool Pack(const std::string& bankFilename, const std::vector<fs::path>& files)
+{
+	std::vector<ParticleSerializer::BankEmitter> emitters;
+	return LoadAll(files, &emitters) && ParticleSerializer::SerializeBank(bankFilename, emitters);
+}
+
+static void PrintUsage()
+{
+	fmt::print(stderr,
+		"Usage: ParticleTool [-j threads] [-t seconds] [-s WIDTHxHEIGHT] [-f frames] <command> <files or directories...>\n"
+		"Commands:\n"
+		"  validate      Check that every file parses\n"
+		"  convert       Convert text files to .pbin and .pbin files to .txt next to the input\n"
+		"  normalize     Rewrite files in canonical form\n"
+		"  fingerprint   Print a hash of each emitter's canonical binary form\n"
+		"  pack <bank>   Pack all inputs into one .pbank file\n"
+		"  state         Print a hash of the deterministic simulation state after -t seconds (default 5)\n"
+		"  render        Draw the simulation after -t seconds on the CPU into a -s sized .png next to the input (default 800x600)\n"
+		"  bake          Bake one looping period into a sheet of -f frames (default 32) of -s size, with a .pflip layout file\n"
+		"  selftest      Check that the inputs round trip exactly through every format, the bank and checkpoints\n"
+		"Directories expand to the emitter files inside, .pbank files only for validate.\n"
+		"Exits with 1 if any file failed, 2 on bad usage or when converted files would overwrite each other.\n");
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Bind(&CaptureLog);
+	// raylib logs to stdout, which is reserved for the results
+	SetTraceLogLevel(LOG_WARNING);
+
+	unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+	int arg = 1;
+	while (arg + 1 < argc && argv[arg][0] == '-')
+	{
+		std::string option = argv[arg];
+		if (option == "-j")
+			threadCount = std::max(1, std::atoi(argv[arg + 1]));
+		else if (option == "-t")
+			simulateSeconds = std::max(0.0f, (float)std::atof(argv[arg + 1]));
+		else if (option == "-s")
+		{
+			if (std::sscanf(argv[arg + 1], "%dx%d", &renderWidth, &renderHeight) != 2 || renderWidth <= 0 || renderHeight <= 0)
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if (option == "-f")
+		{
+			bakeFrames = std::atoi(argv[arg + 1]);
+			if (bakeFrames <= 0)
+			{
+				PrintUsage();
+				return 2;
+			}
+		}
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+		arg += 2;
+	}
+
+	if (arg >= argc)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::string commandName = argv[arg++];
+	std::string bankFilename;
+	if (commandName == "pack")
+	{
+		if (arg >= argc)
+		{
+			PrintUsage();
+			return 2;
+		}
+		bankFilename = argv[arg++];
+	}
+
+	// Only validate reads banks
+	std::vector<fs::path> files = CollectFiles(std::vector<std::string>(argv + arg, argv + argc), commandName == "validate");
+	if (files.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	if (commandName == "pack")
+		return Pack(bankFilename, files) ? 0 : 1;
+	if (commandName == "selftest")
+	{
+		std::vector<ParticleSerializer::BankEmitter> emitters;
+		if (!LoadAll(files, &emitters))
+			return 1;
+
+		// The formats log every file they open, only worth showing when something failed
+		std::string log;
+		capturedLog = &log;
+		int failed = SelfTest::Run(emitters);
+		capturedLog = nullptr;
+		if (failed > 0)
+			fmt::print(stderr, "{}", log);
+		return failed > 0 ? 1 : 0;
+	}
+
+	Command command;
+	if (commandName == "validate")
+		command = &Validate;
+	else if (commandName == "convert")
+	{
+		if (FindConvertCollisions(files))
+			return 2;
+		command = &Convert;
+	}
+	else if (commandName == "normalize")
+		command = &Normalize;
+	else if (commandName == "fingerprint")
+		command = &Fingerprint;
+	else if (commandName == "state")
+		command = &State;
+	else if (commandName == "render" || commandName == "bake")
+	{
+		// Files one after another, each spread over every thread
+		command = commandName == "render" ? &Render : &Bake;
+		renderJobs.Start(threadCount - 1);
+		threadCount = 1;
+	}
+	else
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector<FileResult> results = RunParallel(files, command, threadCount);
+
+	size_t failed = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (results[i].ok)
+			fmt::print("{}  {}\n", results[i].output, files[i].string());
+		else
+		{
+			failed++;
+			fmt::print(stderr, "FAIL {}\n{}", files[i].string(), results[i].log);
+		}
+	}
+
+	if (failed > 0)
+	{
+		fmt::print(stderr, "{} of {} files failed\n", failed, files.size());
+		return 1;
+	}
+
+	return 0;
+}
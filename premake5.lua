@@ -1,3 +1,8 @@
+newoption {
+    trigger = "profile",
+    description = "Keep the profiler timers in Release builds"
+}
+
 workspace "ParticleEditor"
     language "C++"
     cppdialect "C++17"
@@ -8,12 +13,15 @@ workspace "ParticleEditor"
     warnings "Extra"
 
     filter { "configurations:Debug" }
-        defines { "_DEBUG" }
+        defines { "_DEBUG", "PARTICLE_EDITOR_PROFILE" }
         symbols "On"
 
     filter { "configurations:Release" }
         optimize "On"
 
+    filter { "configurations:Release", "options:profile" }
+        defines { "PARTICLE_EDITOR_PROFILE" }
+
     filter { "configurations:Release", "system:Windows" }
         linkoptions { "-static", "-static-libgcc", "-static-libstdc++" }
         links { "pthread" }
@@ -53,3 +61,80 @@ project "ParticleEditor"
 		linkoptions { "`pkg-config gtk+-3.0 --libs`" }
     filter {}
 
+
+project "ParticleBench"
+    kind "ConsoleApp"
+    files {
+        "ParticleBench/**",
+        "ParticleEditor/src/Utils/ParticleSerializer.*",
+        "ParticleEditor/src/Utils/EmitterBank.*",
+        "ParticleEditor/src/Utils/EmitterExtras.h",
+        "ParticleEditor/src/Utils/Expression.*",
+        "ParticleEditor/src/Utils/PropertyBindings.*",
+        "ParticleEditor/src/Utils/Trace.*",
+        "ParticleEditor/src/Utils/JobSystem.*",
+        "ParticleEditor/src/Utils/SoftwareRasterizer.*",
+        "ParticleEditor/src/Simulation/**"
+    }
+
+    includedirs {
+        "ParticleBench/src",
+        "ParticleEditor/src",
+        "Dependencies/Raylib/%{cfg.system}/include",
+        "Dependencies/fmt/%{cfg.system}/include",
+        "../Difu/bin/Difu/%{cfg.longname}/include"
+    }
+
+    libdirs {
+        "Dependencies/Raylib/%{cfg.system}/lib",
+        "Dependencies/fmt/%{cfg.system}/lib",
+        "../Difu/bin/Difu/%{cfg.longname}"
+    }
+
+    filter { "system:Windows" }
+        links { "Difu", "raylib", "fmt", "Winmm", "gdi32", "opengl32", "psapi" }
+        linkoptions { "-static-libstdc++" }
+
+    -- raylib is only linked for the emitter types, no window is ever opened
+    filter { "system:Linux" }
+        links { "Difu", "raylib", "fmt", "pthread", "dl", "m", "X11" }
+    filter {}
+
+project "ParticleTool"
+    kind "ConsoleApp"
+    files {
+        "ParticleTool/**",
+        "ParticleEditor/src/Utils/ParticleSerializer.*",
+        "ParticleEditor/src/Utils/EmitterBank.*",
+        "ParticleEditor/src/Utils/EmitterExtras.h",
+        "ParticleEditor/src/Utils/Expression.*",
+        "ParticleEditor/src/Utils/PropertyBindings.*",
+        "ParticleEditor/src/Utils/Trace.*",
+        "ParticleEditor/src/Utils/JobSystem.*",
+        "ParticleEditor/src/Utils/SoftwareRasterizer.*",
+        "ParticleEditor/src/Utils/FlipbookBaker.*",
+        "ParticleEditor/src/Simulation/**"
+    }
+
+    includedirs {
+        "ParticleTool/src",
+        "ParticleEditor/src",
+        "Dependencies/Raylib/%{cfg.system}/include",
+        "Dependencies/fmt/%{cfg.system}/include",
+        "../Difu/bin/Difu/%{cfg.longname}/include"
+    }
+
+    libdirs {
+        "Dependencies/Raylib/%{cfg.system}/lib",
+        "Dependencies/fmt/%{cfg.system}/lib",
+        "../Difu/bin/Difu/%{cfg.longname}"
+    }
+
+    filter { "system:Windows" }
+        links { "Difu", "raylib", "fmt", "Winmm", "gdi32", "opengl32" }
+        linkoptions { "-static-libstdc++" }
+
+    -- raylib is only linked for the emitter types, no window is ever opened
+    filter { "system:Linux" }
+        links { "Difu", "raylib", "fmt", "pthread", "dl", "m", "X11" }
+    filter {}